@@ -0,0 +1,148 @@
+/*****************************************************************************
+File name: BurstCapture.h
+Description: Event triggered capture at a high output data rate, keeps a
+             pre-trigger history and freezes the samples around a trigger
+             in fixed memory, handed off without copying
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef BURSTCAPTURE_H
+#define BURSTCAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define BURST_BLOCK_SAMPLES     32      // one FIFO read
+#define BURST_POOL_BLOCKS       40      // 7.5 KB of samples
+#define BURST_SNAPSHOT_BLOCKS   14      // longest snapshot, pre + post up to 13 blocks
+#define BURST_SNAPSHOTS         2       // snapshots handed off at the same time
+
+enum BurstTrigger {
+    TRIGGER_MAGNITUDE = 0,      // |a| above threshold
+    TRIGGER_JERK = 1            // one axis changed by more than threshold between two samples
+};
+
+struct BurstConfig {
+    uint8_t trigger;            // BurstTrigger
+    int32_t threshold;          // raw counts
+    uint16_t preSamples;        // kept before the trigger sample
+    uint16_t postSamples;       // from the trigger sample on
+    uint32_t periodUs;          // sample period, for the trigger time
+};
+
+/** Frozen samples around one trigger. They stay in the blocks of the pool
+ *  they were acquired in until BurstCapture::Release().
+ */
+struct BurstSnapshot {
+    uint32_t sequence;          // snapshots taken before this one
+    uint32_t triggerUs;         // time of the trigger sample
+    uint16_t samples;           // pre + post samples
+    uint16_t trigger;           // index of the trigger sample, less than preSamples right after another snapshot
+    uint16_t first;             // position of sample 0 in blocks[0]
+    uint8_t blockCount;
+    int16_t (*blocks[BURST_SNAPSHOT_BLOCKS])[3];
+
+    /** X, Y, Z of sample i, 0 is the oldest. */
+    const int16_t *Sample(uint16_t i) const {
+        uint16_t n = first + i;
+        return blocks[n / BURST_BLOCK_SAMPLES][n % BURST_BLOCK_SAMPLES];
+    }
+};
+
+/** Acquisition writes into fixed size blocks of a pool. Completed blocks
+ *  form the pre-trigger history, only as many as needed to cover
+ *  preSamples are kept. A trigger moves the history and the block being
+ *  filled into a snapshot, which then collects postSamples more blocks;
+ *  acquisition carries on in free blocks all the while.
+ *
+ *  Push() is called by the acquisition side, Ready() and Release() by the
+ *  consumer, which may run in another thread: a snapshot changes hands
+ *  through one atomic state per slot, and released blocks are taken back
+ *  by the next Push().
+ */
+class BurstCapture {
+  public:
+    BurstCapture();
+
+    /** Drops the history and all snapshots and starts over with a configuration.
+    *   No snapshot may be held by the consumer.
+    * @param
+    *     config trigger and lengths, preSamples and postSamples are reduced
+    *     until two snapshots and the history fit in the pool
+    * @return
+    *     None
+    */
+    void Start(const BurstConfig &config);
+
+    /** Appends samples, e.g. one FIFO read.
+    * @param
+    *     xyz n interleaved raw X, Y, Z samples
+    *     n number of samples
+    *     lastUs time of the last sample
+    * @return
+    *     None
+    */
+    void Push(const int16_t *xyz, int n, uint32_t lastUs);
+
+    /** Oldest complete snapshot, the same one until it is released.
+    * @param
+    *     None
+    * @return
+    *     The snapshot, NULL when none is complete.
+    */
+    const BurstSnapshot *Ready(void);
+
+    /** Hands a snapshot from Ready() back, its blocks are reused by the next Push().
+    * @param
+    *     snapshot from Ready()
+    * @return
+    *     None
+    */
+    void Release(const BurstSnapshot *snapshot);
+
+    /** Configuration in use, after the lengths were fitted. */
+    const BurstConfig &Config(void) const { return _config; }
+
+    uint32_t Triggers(void) const { return _triggers; }     // snapshots completed
+    uint32_t Dropped(void) const { return _dropped; }       // triggers without a free snapshot
+
+  private:
+    enum SlotState {
+        SLOT_FREE = 0,
+        SLOT_FILLING,           // post-trigger samples still coming
+        SLOT_READY,             // owned by the consumer
+        SLOT_RELEASED           // blocks to be taken back by Push()
+    };
+
+    bool Triggered(const int16_t *xyz);
+    void StartSnapshot(uint32_t triggerUs);
+    void NewBlock(void);
+    void Reclaim(void);
+
+    int16_t _pool[BURST_POOL_BLOCKS][BURST_BLOCK_SAMPLES][3];
+    uint8_t _free[BURST_POOL_BLOCKS];           // stack of free block indices
+    uint8_t _freeCount;
+    uint8_t _history[BURST_POOL_BLOCKS];        // ring of completed blocks, oldest first
+    uint8_t _historyHead;
+    uint8_t _historyCount;
+    uint8_t _current;                           // block being filled
+    uint8_t _fill;                              // samples in _current
+
+    BurstSnapshot _snapshots[BURST_SNAPSHOTS];
+    uint8_t _snapshotBlocks[BURST_SNAPSHOTS][BURST_SNAPSHOT_BLOCKS];   // pool indices of the blocks
+    std::atomic<uint8_t> _state[BURST_SNAPSHOTS];
+    int8_t _filling;                            // slot in SLOT_FILLING, -1 when none
+    uint16_t _postLeft;
+
+    BurstConfig _config;
+    uint32_t _threshold2;                       // squared magnitude threshold
+    int16_t _prev[3];                           // last sample, for the jerk
+    bool _havePrev;
+    uint32_t _sequence;
+    uint32_t _triggers;
+    uint32_t _dropped;
+};
+
+#endif
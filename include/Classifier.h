@@ -0,0 +1,46 @@
+/*****************************************************************************
+File name: Classifier.h
+Description: On-device exercise classifier, evaluates the quantized decision
+             tree generated by tools/train_classifier.py
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef CLASSIFIER_H
+#define CLASSIFIER_H
+
+#include <stdint.h>
+
+#include "ClassifierModel.h"
+#include "SampleWindow.h"
+
+/** Result of one classification, confidence is the share of training windows
+ *  of each class that ended in the same leaf, scaled to 0 - 255.
+ */
+struct ClassifierResult {
+    uint8_t best;                               // class with the highest confidence
+    uint8_t confidence[MODEL_CLASS_COUNT];      // per class confidence, 0 - 255
+};
+
+/** Computes the int8 features of a window from its angles, in fixed point
+ *  with SampleWindow::AngleQ4(), no floating point. An empty window gives
+ *  neutral features (all 0).
+ * @param
+ *     window filtered samples
+ *     features output, MODEL_FEATURE_COUNT quantized features
+ * @return
+ *     None
+ */
+void extractFeatures(const SampleWindow &window, int8_t features[MODEL_FEATURE_COUNT]);
+
+/** Classifies a window from its features. Uses no floating point and no heap,
+ *  visits at most MODEL_MAX_DEPTH + 1 nodes.
+ * @param
+ *     features MODEL_FEATURE_COUNT features from extractFeatures()
+ *     result output, best class and per class confidence
+ * @return
+ *     None
+ */
+void classify(const int8_t features[MODEL_FEATURE_COUNT], ClassifierResult *result);
+
+#endif
@@ -0,0 +1,98 @@
+/*****************************************************************************
+File name: ClassifierModel.h
+Description: Decision tree tables for the on-device exercise classifier.
+Generated by tools/train_classifier.py from synthetic data -- do not edit.
+*****************************************************************************/
+
+#ifndef CLASSIFIER_MODEL_H
+#define CLASSIFIER_MODEL_H
+
+#include <stdint.h>
+
+#define MODEL_CLASS_COUNT 5
+#define MODEL_FEATURE_COUNT 5
+#define MODEL_NODE_COUNT 29
+#define MODEL_MAX_DEPTH 6
+
+/* exercise classes, in the order of the confidence table columns */
+enum ModelClass {
+    MODEL_SITUPS = 0,
+    MODEL_PUSHUPS = 1,
+    MODEL_JUMPJACKS = 2,
+    MODEL_SQUATS = 3,
+    MODEL_REST = 4,
+};
+
+/* input features, int8: meanX, meanY, meanZ, rangeY, rangeZ */
+enum ModelFeature {
+    FEATURE_MEANX = 0,
+    FEATURE_MEANY = 1,
+    FEATURE_MEANZ = 2,
+    FEATURE_RANGEY = 3,
+    FEATURE_RANGEZ = 4,
+};
+
+/* feature < 0 marks a leaf, left is then the row in MODEL_LEAVES */
+struct ModelNode {
+    int8_t feature;
+    int8_t threshold;          // go left when feature value <= threshold
+    uint8_t left;
+    uint8_t right;
+};
+
+static const char *const MODEL_CLASS_NAMES[MODEL_CLASS_COUNT] = {
+    "SitUps", "PushUps", "JumpJacks", "Squats", "Rest"
+};
+
+constexpr ModelNode MODEL_NODES[MODEL_NODE_COUNT] = {
+    {3, 11, 1, 2},
+    {-1, 0, 0, 0},
+    {2, -3, 3, 14},
+    {2, -50, 4, 11},
+    {0, 10, 5, 10},
+    {1, -2, 6, 9},
+    {1, -6, 7, 8},
+    {-1, 0, 1, 0},
+    {-1, 0, 2, 0},
+    {-1, 0, 3, 0},
+    {-1, 0, 4, 0},
+    {2, -45, 12, 13},
+    {-1, 0, 5, 0},
+    {-1, 0, 6, 0},
+    {1, -8, 15, 16},
+    {-1, 0, 7, 0},
+    {2, 75, 17, 22},
+    {1, 46, 18, 21},
+    {3, 71, 19, 20},
+    {-1, 0, 8, 0},
+    {-1, 0, 9, 0},
+    {-1, 0, 10, 0},
+    {1, 14, 23, 26},
+    {0, -12, 24, 25},
+    {-1, 0, 11, 0},
+    {-1, 0, 12, 0},
+    {3, 42, 27, 28},
+    {-1, 0, 13, 0},
+    {-1, 0, 14, 0},
+};
+
+/* per class confidence of each leaf, 0 - 255 */
+constexpr uint8_t MODEL_LEAVES[15][MODEL_CLASS_COUNT] = {
+    {0, 0, 0, 0, 255},
+    {0, 252, 2, 0, 0},
+    {0, 221, 33, 0, 0},
+    {0, 136, 119, 0, 0},
+    {0, 0, 255, 0, 0},
+    {0, 42, 212, 0, 0},
+    {0, 0, 255, 0, 0},
+    {74, 0, 0, 180, 0},
+    {134, 0, 0, 120, 0},
+    {102, 0, 0, 152, 0},
+    {178, 0, 0, 76, 0},
+    {160, 0, 0, 94, 0},
+    {122, 0, 0, 132, 0},
+    {81, 0, 0, 173, 0},
+    {114, 0, 0, 140, 0},
+};
+
+#endif
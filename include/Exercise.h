@@ -0,0 +1,74 @@
+/*****************************************************************************
+File name: Exercise.h
+Description: Table of the exercises the counter knows, everything that
+             differs between two exercises is one row of EXERCISES
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef EXERCISE_H
+#define EXERCISE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ClassifierModel.h"
+#include "SampleWindow.h"
+
+/* board LEDs, index into the LED table of main.cpp */
+enum ExerciseLed {
+    LED_ORANGE = 0,             // LED3
+    LED_GREEN = 1,              // LED4
+    LED_RED = 2,                // LED5
+    LED_BLUE = 3                // LED6
+};
+
+/** One exercise, read by the single counting loop in main.cpp. */
+struct ExerciseDescriptor {
+    uint8_t exercise;           // ModelClass the classifier reports for it
+    Axis axis;                  // axis whose angle maxima are repetitions
+    uint8_t targetReps;         // a set ends after this many repetitions
+    uint8_t minConfidence;      // classifier confidence (0 - 255) needed to start counting
+    uint8_t led;                // ExerciseLed showing the progress
+};
+
+/* in routine order; adding an exercise is one more row (and a class in the model) */
+constexpr ExerciseDescriptor EXERCISES[] = {
+    {MODEL_SITUPS,    AXIS_Y, 5, 160, LED_ORANGE},
+    {MODEL_PUSHUPS,   AXIS_Y, 5, 160, LED_RED},
+    {MODEL_JUMPJACKS, AXIS_Y, 5, 160, LED_BLUE},
+    {MODEL_SQUATS,    AXIS_Y, 5, 160, LED_GREEN},
+};
+
+constexpr int EXERCISE_COUNT = sizeof(EXERCISES) / sizeof(EXERCISES[0]);
+
+/* every row names a distinct exercise class of the model */
+constexpr bool exercisesValid(int i = 0) {
+    if (i == EXERCISE_COUNT) {
+        return true;
+    }
+    for (int j = 0; j < i; j++) {
+        if (EXERCISES[j].exercise == EXERCISES[i].exercise) {
+            return false;
+        }
+    }
+    return EXERCISES[i].exercise < MODEL_CLASS_COUNT && EXERCISES[i].exercise != MODEL_REST
+        && EXERCISES[i].led <= LED_BLUE && EXERCISES[i].targetReps > 0 && exercisesValid(i + 1);
+}
+static_assert(exercisesValid(), "EXERCISES: duplicate, unknown or rest class, or bad LED");
+
+/** Finds the row of a classifier class.
+* @param
+*     exercise ModelClass
+* @return
+*     The descriptor, NULL for MODEL_REST or a class without a row.
+*/
+inline const ExerciseDescriptor *findExercise(uint8_t exercise) {
+    for (int i = 0; i < EXERCISE_COUNT; i++) {
+        if (EXERCISES[i].exercise == exercise) {
+            return &EXERCISES[i];
+        }
+    }
+    return NULL;
+}
+
+#endif
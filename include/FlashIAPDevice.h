@@ -0,0 +1,33 @@
+/*****************************************************************************
+File name: FlashIAPDevice.h
+Description: FlashDevice on the STM32 internal flash through mbed FlashIAP
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef FLASHIAPDEVICE_H
+#define FLASHIAPDEVICE_H
+
+#include "mbed.h"
+#include "SessionLog.h"
+
+#if DEVICE_FLASH
+
+/** Internal flash through FlashIAP, initialised on first use. */
+class FlashIAPDevice : public FlashDevice {
+  public:
+    FlashIAPDevice();
+    virtual int Read(uint32_t addr, void *buffer, uint32_t size);
+    virtual int Program(uint32_t addr, const void *buffer, uint32_t size);
+    virtual int Erase(uint32_t addr, uint32_t size);
+
+  private:
+    int Init(void);
+
+    FlashIAP _flash;
+    bool _ready;
+};
+
+#endif
+
+#endif
@@ -41,7 +41,7 @@
  *    int16_t X, Y, Z;    //signed integer variables for raw X,Y,Z values
  *    float roll, pitch;  //float variables for angles
  *    
- *    if(acc.Detect() != 1) {
+ *    if(acc.Begin(100000) != 0) {
  *        printf("LIS3DSH Acceleromoter not detected!\n");
  *        while(1){ };
  *    }
@@ -57,16 +57,82 @@
  *}
  * @endcode
  */
+
+/** Result of LIS3DSH::Calibrate(), all values in raw counts. */
+struct LIS3DSHCalibration {
+    int8_t offset[3];       // OFF_X, OFF_Y, OFF_Z, the output is reduced by offset * 32
+    int16_t bias[3];        // mean error before calibration
+    int16_t residual[3];    // mean error with the new offsets
+    uint16_t spread[3];     // peak to peak of each axis during the capture
+};
+ 
+/** Fault counters of LIS3DSH::ReadChecked(), since power up. */
+struct LIS3DSHHealth {
+    uint32_t samples;           // new samples returned
+    uint32_t staleReads;        // reads without a new sample (STATUS ZYXDA clear)
+    uint32_t stalls;            // no new sample for STALL_PERIODS output data periods
+    uint32_t frozen;            // FROZEN_SAMPLES identical samples in a row
+    uint32_t identityErrors;    // WHO_AM_I mismatch
+    uint32_t busErrors;         // every byte of a read was 0xFF
+    uint32_t recoveries;        // successful re-initializations
+    uint32_t failedRecoveries;  // re-initializations that did not bring the sensor back
+    uint32_t lastRecoveryUs;    // fault detected to the first new sample
+    uint32_t maxRecoveryUs;
+};
  
 class LIS3DSH {
   public:
+    static const uint8_t STALL_PERIODS = 4;         // stale reads spanning this many ODR periods are a stall
+    static const uint8_t FROZEN_SAMPLES = 8;        // identical samples, the noise alone changes a live sensor
+    static const uint8_t IDENTITY_INTERVAL = 16;    // WHO_AM_I checked every this many reads
+    static const uint32_t RETRY_INTERVAL_US = 500000;   // between two failed re-initializations
+    static const uint8_t FIFO_DEPTH = 32;           // samples held by the FIFO
+
+    /** Full scale ranges, the FSCALE field of CTRL_REG5. */
+    enum FullScale {
+        FS_2G = 0,
+        FS_4G = 1,
+        FS_6G = 2,
+        FS_8G = 3,
+        FS_16G = 4
+    };
+
+    /** Output data rates, the ODR field of CTRL_REG4. */
+    enum DataRate {
+        ODR_3_125HZ = 1,
+        ODR_6_25HZ = 2,
+        ODR_12_5HZ = 3,
+        ODR_25HZ = 4,
+        ODR_50HZ = 5,
+        ODR_100HZ = 6,
+        ODR_400HZ = 7,
+        ODR_800HZ = 8,
+        ODR_1600HZ = 9
+    };
+
     /** Create a LIS3DSH object connected to the specified pins.
     * @param mosi SPI compatible pin used for the LIS3DSH's MOSI pin
     * @param miso SPI compatible pin used for the LIS3DSH's MISO pin
     * @param clk SPI compatible pin used for the LIS3DSH's CLK pin
     * @param cs DigitalOut compatible pin used for the LIS3DSH's CS pin
+    *
+    * Only the SPI interface is set up, the sensor is left alone until Begin().
     */
     LIS3DSH(PinName mosi, PinName miso, PinName clk, PinName cs);
+
+    /** Resets and configures the sensor: soft reset (CTRL_REG3 STRT) and
+    *   reboot (CTRL_REG6 BOOT), both polled until the part clears them,
+    *   then 12.5 Hz ODR, +/- 2g, FIFO bypass and address auto-increment.
+    *   Returns as soon as the first sample is latched. The offsets are back
+    *   to 0 afterwards.
+    * @param 
+    *     timeoutUs longest wait for the sensor to answer and for each reset
+    *         step
+    * @return 
+    *     0 = first sample ready; -1 = not detected; -2 = no data;
+    *     -3 = reset did not finish.
+    */
+    int Begin(uint32_t timeoutUs);
  
     /** Determines if the LIS3DSH acceleromoter can be detected.
     * @param 
@@ -75,6 +141,14 @@ class LIS3DSH {
     *     1 = detected; 0 = not detected.
     */
     int Detect(void);
+
+    /** Retries Detect() until the sensor answers, e.g. while it boots after power up.
+    * @param 
+    *     timeoutUs longest wait, polled every 100 us
+    * @return 
+    *     1 = detected; 0 = not detected within the timeout.
+    */
+    int Detect(uint32_t timeoutUs);
     
     /** Write a byte of data to the LIS3DSH at a selected address.
     * @param 
@@ -93,7 +167,8 @@ class LIS3DSH {
     */
     uint8_t ReadReg(uint8_t addr);
     
-    /** Reads the raw X, Y, Z values from the LIS3DSH as signed 16-bit values (int16_t).
+    /** Reads the raw X, Y, Z values from the LIS3DSH as signed 16-bit values (int16_t),
+    *   all six output registers in one SPI transaction.
     * @param 
     *     *X Reference to variable for the raw X value
     *     *Y Reference to variable for the raw Y value
@@ -103,7 +178,31 @@ class LIS3DSH {
     */
     void ReadData(int16_t *X, int16_t *Y, int16_t *Z);
     
-    /** Reads the roll angle and pitch angle from the LIS3DSH.
+    /** Reads a sample like ReadData(), checked for faults. STATUS is read in
+    *   the same transaction, WHO_AM_I every IDENTITY_INTERVAL calls. On a
+    *   stall, frozen output, identity mismatch or bus error the sensor is
+    *   re-initialized with Begin() and the offsets, full scale, data rate
+    *   and FIFO mode are programmed again. Not for use while the FIFO is
+    *   on. A failed attempt is retried after RETRY_INTERVAL_US until one
+    *   succeeds. One attempt blocks for at most 400 ms: 100 ms each for
+    *   WHO_AM_I, soft reset, reboot and the first sample. Restoring
+    *   non-default settings adds up to 2 ODR periods, at least 100 ms
+    *   (500 ms in total at 25 Hz and above).
+    * @param 
+    *     *X Reference to variable for the raw X value
+    *     *Y Reference to variable for the raw Y value
+    *     *Z Reference to variable for the raw Z value
+    * @return 
+    *     0 = new sample; 1 = no new sample yet, the last one is returned;
+    *     -1 = fault, recovered, the sample is the first after the restart;
+    *     -2 = fault, not recovered yet, the last sample is returned.
+    */
+    int ReadChecked(int16_t *X, int16_t *Y, int16_t *Z);
+
+    /** Fault counters of ReadChecked(). */
+    const LIS3DSHHealth &Health(void) const { return _health; }
+
+    /** Reads one sample and converts it with ToRollPitch().
     * @param 
     *     *Roll Reference to variable for the roll angle (0.0 - 359.999999)
     *     *Pitch Reference to variable for the pitch angle (0.0 - 359.999999)
@@ -111,11 +210,153 @@ class LIS3DSH {
     *     None
     */
     void ReadAngles(float *Roll, float *Pitch);
+    
+    /** Converts a vertical and a horizontal acceleration to an angle.
+    * @param 
+    *     V acceleration along the vertical axis
+    *     H acceleration along the horizontal axis
+    * @return 
+    *     Angle between the two planes in degrees (0.0 - 359.999999)
+    */
+    static float gToDegrees(float V, float H);
+
+    /** Converts raw samples to g with the scale of the configured full scale.
+    * @param 
+    *     xyz n interleaved raw X, Y, Z samples
+    *     out 3 * n values in g, may not overlap xyz
+    *     n number of samples
+    * @return 
+    *     None
+    */
+    void ToG(const int16_t *xyz, float *out, size_t n) const;
+
+    /** Converts raw samples to roll and pitch angles, same angles as
+    *   ReadAngles() but without rounding the inputs. The scale cancels out.
+    * @param 
+    *     xyz n interleaved raw X, Y, Z samples
+    *     roll n roll angles in degrees (0.0 - 359.999999)
+    *     pitch n pitch angles in degrees (0.0 - 359.999999)
+    *     n number of samples
+    * @return 
+    *     None
+    */
+    static void ToRollPitch(const int16_t *xyz, float *roll, float *pitch, size_t n);
+
+    /** Sets the measurement range.
+    * @param 
+    *     fs one of FullScale
+    * @return 
+    *     None
+    */
+    void SetFullScale(FullScale fs);
+
+    /** Sets the output data rate, all axes stay enabled.
+    * @param 
+    *     odr one of DataRate
+    * @return 
+    *     None
+    */
+    void SetDataRate(DataRate odr);
+
+    /** Configured output data rate. */
+    DataRate GetDataRate(void) const { return _dataRate; }
+
+    /** Time between two samples at a data rate.
+    * @param 
+    *     odr one of DataRate
+    * @return 
+    *     Period in microseconds, rounded.
+    */
+    static uint32_t PeriodUs(DataRate odr);
+
+    /** Switches the FIFO between bypass and stream mode. In stream mode the
+    *   last FIFO_DEPTH samples queue up and are read with ReadFifo(), the
+    *   oldest is dropped when the FIFO is full.
+    * @param 
+    *     enable true = stream mode; false = bypass, ReadData() as usual
+    * @return 
+    *     None
+    */
+    void SetFifo(bool enable);
+
+    /** Reads the queued samples of the FIFO, oldest first, in one SPI transaction.
+    * @param 
+    *     xyz room for maxSamples interleaved X, Y, Z samples
+    *     maxSamples largest number of samples read, FIFO_DEPTH empties the FIFO
+    *     *Overrun Reference to variable set when samples were dropped since
+    *         the last read, may be NULL
+    * @return 
+    *     Number of samples read.
+    */
+    int ReadFifo(int16_t *xyz, int maxSamples, bool *Overrun);
+
+    /** Configured measurement range. */
+    FullScale GetFullScale(void) const { return _fullScale; }
+
+    /** Raw value read at 1g for a full scale, from the datasheet sensitivity.
+    * @param 
+    *     fs one of FullScale
+    * @return 
+    *     Counts per g (16667 at +/- 2g).
+    */
+    static int16_t CountsPerG(FullScale fs);
+
+    /** Raw value read at 1g with the configured full scale. */
+    int16_t CountsPerG(void) const { return CountsPerG(_fullScale); }
+
+    /** Measures the zero-g bias and corrects it in the OFF_X/Y/Z registers.
+    *   The board must lie still with one axis vertical, that axis is expected
+    *   to read +/- countsPerG and the other two 0. The offsets already
+    *   programmed are taken into account.
+    * @param 
+    *     samples number of samples averaged, before and after
+    *     countsPerG raw value of 1g
+    *     *Result Reference to variable for the offsets and errors
+    * @return 
+    *     0 = calibrated; -1 = board moved; -2 = no data from the sensor.
+    */
+    int Calibrate(uint16_t samples, int16_t countsPerG, LIS3DSHCalibration *Result);
+
+    /** Writes the OFF_X, OFF_Y, OFF_Z registers, e.g. with a stored calibration.
+    *   They are kept and written again after a recovery.
+    * @param 
+    *     offset values for OFF_X, OFF_Y, OFF_Z
+    * @return 
+    *     None
+    */
+    void SetOffsets(const int8_t offset[3]);
+
+    /** Reads the OFF_X, OFF_Y, OFF_Z registers.
+    * @param 
+    *     offset Reference to array for the three values
+    * @return 
+    *     None
+    */
+    void GetOffsets(int8_t offset[3]);
  
   private:
+    int Init(uint32_t timeoutUs, uint32_t dataTimeoutUs);
+    bool WaitDataReady(uint32_t timeoutUs);
+    bool WaitRegClear(uint8_t addr, uint8_t mask, uint32_t timeoutUs);
+    int Recover(void);
+    int Average(uint16_t samples, int32_t mean[3], uint16_t spread[3]);
+
+    FullScale _fullScale;
+    DataRate _dataRate;
+    bool _fifo;                 // stream mode
+    float _gPerCount;           // from _fullScale, used by ToG()
+    int8_t _offset[3];          // last SetOffsets(), restored by a recovery
+    LIS3DSHHealth _health;
+    int16_t _last[3];           // last sample of ReadChecked()
+    uint8_t _repeats;           // samples equal to _last in a row
+    uint8_t _sinceIdentity;     // reads since the last WHO_AM_I check
+    bool _stale;                // the reads since _staleSinceUs had no new sample
+    bool _failed;               // last recovery failed, retried at _retryAtUs
+    uint32_t _staleSinceUs;
+    uint32_t _detectedUs;       // fault detection, start of the recovery latency
+    uint32_t _retryAtUs;
     SPI _spi;
     DigitalOut _cs; 
-    float gToDegrees(float V, float H);
 };
  
 #endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*****************************************************************************
+File name: MovingAverage.h
+Description: Moving average filter over raw X, Y, Z accelerometer samples
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef MOVINGAVERAGE_H
+#define MOVINGAVERAGE_H
+
+#include <stdint.h>
+
+/** Moving average over the last LENGTH raw samples of each axis.
+ *
+ * Keeps the raw int16 values in a ring buffer and a running sum per axis,
+ * so one update costs the same whatever the filter length.
+ */
+class MovingAverage {
+  public:
+    static const uint8_t LENGTH = 20;           // filter length
+
+    /** Create a filter with an all zero history. */
+    MovingAverage();
+
+    /** Clears the history back to zero.
+    * @param
+    *     None
+    * @return
+    *     None
+    */
+    void Reset(void);
+
+    /** Inserts one raw sample and returns the filtered sample.
+    * @param
+    *     x, y, z raw values from LIS3DSH::ReadData()
+    *     *fx, *fy, *fz Reference to variables for the filtered values
+    * @return
+    *     None
+    */
+    void Push(int16_t x, int16_t y, int16_t z, int16_t *fx, int16_t *fy, int16_t *fz);
+
+  private:
+    int16_t _ring[LENGTH][3];
+    int32_t _sum[3];
+    uint8_t _index;
+};
+
+#endif
@@ -0,0 +1,184 @@
+/*****************************************************************************
+File name: Pipeline.h
+Description: Stream pipeline composed at compile time, stages are plain
+             classes chained by templates, no virtual calls and no heap
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+
+/* A stage is any class with
+ *
+ *     template <class Next> void Push(const In &in, Next &next);
+ *
+ * which calls next(out) for each output, any number of times per input
+ * (once for a map, N - 1 times none and then once for a buffer). Pipeline
+ * hands every stage the rest of the chain as next, so the calls of one
+ * sample are nested inline functions the compiler fuses into one loop body.
+ * A Pipeline is a stage itself and can be nested in another one.
+ */
+
+/** Last next of a pipeline pushed without one, drops the output. */
+struct Discard {
+    template <class T>
+    void operator()(const T &) {}
+};
+
+template <class... Stages>
+class Pipeline;
+
+/** End of the chain, forwards to the next of the caller. */
+template <>
+class Pipeline<> {
+  public:
+    template <class In, class Next>
+    void Push(const In &in, Next &next) { next(in); }
+};
+
+/** Stages in order, held by value, the first receives the pushed inputs. */
+template <class Stage, class... Rest>
+class Pipeline<Stage, Rest...> {
+  public:
+    Pipeline(const Stage &stage, const Rest &... rest)
+    : _stage(stage), _rest(rest...)
+    {
+    }
+
+    /** Pushes one input through all stages, the output of the last one is dropped.
+    * @param
+    *     in input of the first stage
+    * @return
+    *     None
+    */
+    template <class In>
+    void Push(const In &in) {
+        Discard discard;
+        Push(in, discard);
+    }
+
+    /** Pushes one input through all stages.
+    * @param
+    *     in input of the first stage
+    *     next called with each output of the last stage
+    * @return
+    *     None
+    */
+    template <class In, class Next>
+    void Push(const In &in, Next &next) {
+        auto forward = [this, &next](const auto &out) { _rest.Push(out, next); };
+        _stage.Push(in, forward);
+    }
+
+    /** Pushes n inputs in order, e.g. one FIFO read.
+    * @param
+    *     in n inputs of the first stage
+    *     n number of inputs
+    * @return
+    *     None
+    */
+    template <class In>
+    void PushBlock(const In *in, int n) {
+        Discard discard;
+        PushBlock(in, n, discard);
+    }
+
+    template <class In, class Next>
+    void PushBlock(const In *in, int n, Next &next) {
+        for (int i = 0; i < n; i++) {
+            Push(in[i], next);
+        }
+    }
+
+    /** First stage and the pipeline of the others. */
+    Stage &Head(void) { return _stage; }
+    Pipeline<Rest...> &Tail(void) { return _rest; }
+
+  private:
+    Stage _stage;
+    Pipeline<Rest...> _rest;
+};
+
+/** Pipeline of the given stages, with the types deduced. */
+template <class... Stages>
+Pipeline<Stages...> makePipeline(const Stages &... stages) {
+    return Pipeline<Stages...>(stages...);
+}
+
+/********** generic stages ********************/
+
+/** Applies a function to every input, map stages next to each other fuse
+ *  into one expression.
+ */
+template <class Fn>
+class Map {
+  public:
+    explicit Map(const Fn &fn) : _fn(fn) {}
+
+    template <class In, class Next>
+    void Push(const In &in, Next &next) { next(_fn(in)); }
+
+  private:
+    Fn _fn;
+};
+
+template <class Fn>
+Map<Fn> makeMap(const Fn &fn) {
+    return Map<Fn>(fn);
+}
+
+/** Hands every input to a function and ends the chain. */
+template <class Fn>
+class Sink {
+  public:
+    explicit Sink(const Fn &fn) : _fn(fn) {}
+
+    template <class In, class Next>
+    void Push(const In &in, Next &) { _fn(in); }
+
+  private:
+    Fn _fn;
+};
+
+template <class Fn>
+Sink<Fn> makeSink(const Fn &fn) {
+    return Sink<Fn>(fn);
+}
+
+/** N inputs handed on at once by Batch, valid during the call of next. */
+template <class T>
+struct BatchView {
+    const T *items;
+    int n;
+};
+
+/** Fixed capacity buffer between two stages, collects N inputs and passes
+ *  them on as one BatchView, e.g. for a stage that works on blocks.
+ */
+template <class T, int N>
+class Batch {
+  public:
+    Batch() : _count(0) {}
+
+    /** Drops the inputs collected so far. */
+    void Reset(void) { _count = 0; }
+
+    template <class Next>
+    void Push(const T &in, Next &next) {
+        _items[_count++] = in;
+        if (_count == N) {
+            BatchView<T> view = {_items, N};
+            _count = 0;
+            next(view);
+        }
+    }
+
+  private:
+    T _items[N];
+    int _count;
+};
+
+#endif
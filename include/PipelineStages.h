@@ -0,0 +1,147 @@
+/*****************************************************************************
+File name: PipelineStages.h
+Description: The sampling and classification chain of the firmware as
+             pipeline stages (Pipeline.h): read, moving average, window,
+             features, classification and repetition count
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef PIPELINESTAGES_H
+#define PIPELINESTAGES_H
+
+#include <stdint.h>
+
+#include "Pipeline.h"
+#include "LIS3DSH.h"
+#include "MovingAverage.h"
+#include "SampleWindow.h"
+#include "Classifier.h"
+
+/** One raw or filtered sample. */
+struct RawSample {
+    int16_t x, y, z;
+    uint32_t timestampUs;
+};
+
+/** Features of a full window, the window stays valid during the call of next. */
+struct WindowFeatures {
+    const SampleWindow *window;
+    int8_t features[MODEL_FEATURE_COUNT];
+};
+
+/** Classification and repetitions of a full window. */
+struct WindowResult {
+    const SampleWindow *window;
+    ClassifierResult result;
+    int reps;                                   // set by PeakStage
+};
+
+/* The stages keep references to the objects that hold their state, so the
+   same filter or window can still be reached from outside the pipeline. */
+
+/** Source: reads one sample per pushed timestamp with LIS3DSH::ReadChecked(),
+ *  a locked up sensor is restarted by the driver.
+ */
+class ReadStage {
+  public:
+    explicit ReadStage(LIS3DSH &acc) : _acc(acc) {}
+
+    template <class Next>
+    void Push(uint32_t timestampUs, Next &next) {
+        RawSample out;
+        _acc.ReadChecked(&out.x, &out.y, &out.z);
+        out.timestampUs = timestampUs;
+        next(out);
+    }
+
+  private:
+    LIS3DSH &_acc;
+};
+
+/** Moving average of the raw samples. */
+class FilterStage {
+  public:
+    explicit FilterStage(MovingAverage &filter) : _filter(filter) {}
+
+    template <class Next>
+    void Push(const RawSample &in, Next &next) {
+        RawSample out;
+        _filter.Push(in.x, in.y, in.z, &out.x, &out.y, &out.z);
+        out.timestampUs = in.timestampUs;
+        next(out);
+    }
+
+  private:
+    MovingAverage &_filter;
+};
+
+/** Fixed capacity buffer of SampleWindow::LENGTH samples, passes the window on
+ *  once it is full and starts a new one with the next sample. A window
+ *  cleared from outside (e.g. sampleTwoSeconds()) starts over as well.
+ *  Angles are derived from the window (SampleWindow::Angle()), as the
+ *  exercise logic does, so there is no per sample angle stage.
+ */
+class WindowStage {
+  public:
+    explicit WindowStage(SampleWindow &window) : _window(window) {}
+
+    template <class Next>
+    void Push(const RawSample &in, Next &next) {
+        if (_window.Full()) {
+            _window.Clear();
+        }
+        _window.Push(in.x, in.y, in.z, in.timestampUs);
+        if (_window.Full()) {
+            next(_window);
+        }
+    }
+
+  private:
+    SampleWindow &_window;
+};
+
+/** extractFeatures() of each full window. */
+class FeatureStage {
+  public:
+    template <class Next>
+    void Push(const SampleWindow &in, Next &next) {
+        WindowFeatures out;
+        out.window = &in;
+        extractFeatures(in, out.features);
+        next(out);
+    }
+};
+
+/** classify() of each window, reps are left at 0. */
+class ClassifyStage {
+  public:
+    template <class Next>
+    void Push(const WindowFeatures &in, Next &next) {
+        WindowResult out;
+        out.window = in.window;
+        classify(in.features, &out.result);
+        out.reps = 0;
+        next(out);
+    }
+};
+
+/** Counts the repetitions of a classified window along one axis,
+ *  SampleWindow::CountPeaks().
+ */
+class PeakStage {
+  public:
+    explicit PeakStage(Axis axis) : _axis(axis) {}
+
+    template <class Next>
+    void Push(const WindowResult &in, Next &next) {
+        WindowResult out = in;
+        out.reps = in.window->CountPeaks(_axis);
+        next(out);
+    }
+
+  private:
+    Axis _axis;
+};
+
+#endif
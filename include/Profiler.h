@@ -0,0 +1,132 @@
+/*****************************************************************************
+File name: Profiler.h
+Description: Scoped hot path timers, DWT cycle counter on the board and
+             std::chrono on the host
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+/* instrumented hot paths */
+enum ProbeId {
+    PROBE_READ_DATA = 0,        // LIS3DSH::ReadData(), ReadChecked(), without recoveries
+    PROBE_SAMPLING,             // sampling(), read + filter + window
+    PROBE_FILTER,               // MovingAverage::Push()
+    PROBE_CLASSIFY,             // extractFeatures() + classify()
+    PROBE_COUNT_REPS,           // SampleWindow::CountPeaks()
+    PROBE_COUNT
+};
+
+#define PROFILER_BUCKETS 32     // log2 histogram, bucket k holds [2^(k-1), 2^k) ticks
+
+/** Statistics of one probe, kept in fixed memory. */
+struct ProbeStats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint16_t histogram[PROFILER_BUCKETS];      // saturates at 65535
+};
+
+#ifdef PROFILER_ENABLED
+
+/** Starts the tick source, enables DWT CYCCNT on Cortex-M.
+* @param
+*     None
+* @return
+*     None
+*/
+void profilerInit(void);
+
+/** Current tick count, CPU cycles on the board and nanoseconds on the host. */
+uint32_t profilerNow(void);
+
+/** Adds one measurement to a probe.
+* @param
+*     id probe
+*     ticks elapsed ticks
+* @return
+*     None
+*/
+void profilerRecord(ProbeId id, uint32_t ticks);
+
+/** Statistics of a probe. */
+const ProbeStats *profilerStats(ProbeId id);
+
+/** Clears all probes. */
+void profilerReset(void);
+
+/** Stops / restarts recording a probe, calls nest. A scope of the probe that
+ *  overlaps a suspension is dropped as a whole, see ProfileSuspend.
+* @param
+*     id probe
+* @return
+*     None
+*/
+void profilerSuspend(ProbeId id);
+void profilerResume(ProbeId id);
+
+/** Number of suspensions of a probe so far, for ProfileScope. */
+uint32_t profilerSuspensions(ProbeId id);
+
+/** Writes the statistics of all probes, one line per call of print.
+* @param
+*     print function writing one '\n' terminated line
+* @return
+*     None
+*/
+void profilerDump(void (*print)(const char *line));
+
+/** Records the time between construction and destruction into a probe,
+ *  unless the probe was suspended in between.
+ */
+class ProfileScope {
+  public:
+    explicit ProfileScope(ProbeId id)
+    : _id(id), _suspensions(profilerSuspensions(id)), _start(profilerNow()) {}
+    ~ProfileScope() {
+        uint32_t ticks = profilerNow() - _start;
+        if (profilerSuspensions(_id) == _suspensions) {
+            profilerRecord(_id, ticks);
+        }
+    }
+
+  private:
+    ProbeId _id;
+    uint32_t _suspensions;
+    uint32_t _start;
+};
+
+/** Suspends a probe while alive: nested scopes and the enclosing scope of the
+ *  same probe are not recorded, e.g. a sensor recovery inside a checked read
+ *  is neither read time nor an extra read.
+ */
+class ProfileSuspend {
+  public:
+    explicit ProfileSuspend(ProbeId id) : _id(id) { profilerSuspend(id); }
+    ~ProfileSuspend() { profilerResume(_id); }
+
+  private:
+    ProbeId _id;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_INIT() profilerInit()
+#define PROFILE_SCOPE(id) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(id)
+#define PROFILE_SUSPEND(id) ProfileSuspend PROFILE_CONCAT(_profileSuspend, __LINE__)(id)
+
+#else
+
+/* compiled out, probes generate no code */
+#define PROFILE_INIT()
+#define PROFILE_SCOPE(id)
+#define PROFILE_SUSPEND(id)
+
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+/*****************************************************************************
+File name: SampleCodec.h
+Description: Streaming lossless codec for interleaved int16 X, Y, Z samples,
+             per axis prediction + zigzag + adaptive Rice coding
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* residual predictors */
+enum Predictor {
+    PREDICT_DELTA = 0,          // previous sample
+    PREDICT_LINEAR = 1          // 2 * previous - the one before
+};
+
+#define CODEC_HEADER_BYTES      5       // uint16 samples, uint16 payload bytes, uint8 predictor
+#define CODEC_MAX_SAMPLE_BITS   126     // 3 axes x (24 bit escape + 18 bit residual)
+
+/* a capture stream is the magic, the uint32 sample period in microseconds,
+   the blocks, then a block of 0 samples */
+#define CODEC_STREAM_MAGIC      "XYZC"
+
+/* worst case size of a block of n samples, for sizing the output buffer */
+#define CODEC_MAX_BLOCK_BYTES(n) (CODEC_HEADER_BYTES + ((n) * CODEC_MAX_SAMPLE_BITS + 7) / 8)
+
+/** Per axis coder state, reset at every block so blocks decode on their own.
+ *  The first sample of a block is stored as is, later ones as Rice coded
+ *  residuals with k following the running mean (LOCO-I style).
+ */
+struct AxisState {
+    int32_t prev1;
+    int32_t prev2;
+    uint32_t sum;               // running sum of zigzag residuals
+    uint16_t count;
+};
+
+/** Encodes samples into self contained blocks in a caller provided buffer.
+ *
+ * Memory is the buffer plus this object, every sample costs the same few
+ * shifts and compares whatever the block size.
+ */
+class SampleEncoder {
+  public:
+    explicit SampleEncoder(Predictor predictor = PREDICT_DELTA);
+
+    /** Starts a block.
+    * @param
+    *     out buffer, CODEC_MAX_BLOCK_BYTES(samples) bytes guarantee no overflow
+    *     capacity size of out
+    * @return
+    *     None
+    */
+    void Begin(uint8_t *out, size_t capacity);
+
+    /** Adds one X, Y, Z sample to the block.
+    * @param
+    *     xyz raw sample
+    * @return
+    *     false when the buffer is full, the sample was not added.
+    */
+    bool Push(const int16_t xyz[3]);
+
+    /** Closes the block and writes its header.
+    * @param
+    *     None
+    * @return
+    *     Block size in bytes.
+    */
+    size_t Finish(void);
+
+    uint16_t Samples(void) const { return _samples; }
+
+  private:
+    void PutBits(uint32_t value, uint8_t bits);
+
+    Predictor _predictor;
+    AxisState _axis[3];
+    uint8_t *_out;
+    size_t _capacity;
+    size_t _pos;                // next byte of the payload
+    uint32_t _bits;             // pending bits, LSB first
+    uint8_t _nbits;
+    uint16_t _samples;
+};
+
+/** Decodes a block written by SampleEncoder.
+* @param
+*     block start of the block
+*     length bytes available from block
+*     xyz output, interleaved X, Y, Z
+*     maxSamples room in xyz, in samples
+*     *used Reference to variable for the block size in bytes
+* @return
+*     Number of samples decoded, -1 for a truncated or corrupt block.
+*/
+int decodeBlock(const uint8_t *block, size_t length, int16_t *xyz, size_t maxSamples, size_t *used);
+
+#endif
@@ -0,0 +1,71 @@
+/*****************************************************************************
+File name: SampleScheduler.h
+Description: Fixed rate sampling on an absolute deadline grid, with
+             monotonic timestamps, jitter statistics and missed deadlines
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef SAMPLESCHEDULER_H
+#define SAMPLESCHEDULER_H
+
+#include <stdint.h>
+
+/** Timing statistics since the last ResetStats(). Lateness is the time
+ *  between a deadline and the wake up, interval the time between two wake ups.
+ */
+struct JitterStats {
+    uint32_t samples;           // deadlines met
+    uint32_t missed;            // deadlines skipped because they had already passed
+    uint32_t minLateUs;
+    uint32_t maxLateUs;
+    uint64_t sumLateUs;
+    uint32_t minIntervalUs;
+    uint32_t maxIntervalUs;
+};
+
+/** Wakes up on start + k * period, so time spent reading and processing a
+ *  sample no longer stretches the period. Deadlines that passed while the
+ *  caller was busy are skipped and counted instead of being run late.
+ */
+class SampleScheduler {
+  public:
+    /** Create a scheduler.
+    * @param
+    *     periodUs sampling period in microseconds
+    */
+    explicit SampleScheduler(uint32_t periodUs);
+
+    /** Anchors the deadline grid, the first WaitNext() returns immediately
+    *   and measures no interval, so pauses between two runs do not count.
+    * @param
+    *     None
+    * @return
+    *     None
+    */
+    void Start(void);
+
+    /** Sleeps until the next deadline on the grid.
+    * @param
+    *     *timestampUs Reference to variable for the wake up time (Now())
+    * @return
+    *     Number of deadlines skipped before this one, 0 when on time.
+    */
+    uint32_t WaitNext(uint64_t *timestampUs);
+
+    /** Monotonic time in microseconds, the 64 bit us ticker of the HAL. */
+    static uint64_t Now(void);
+
+    uint32_t PeriodUs(void) const { return _periodUs; }
+    const JitterStats &Stats(void) const { return _stats; }
+    void ResetStats(void);
+
+  private:
+    uint32_t _periodUs;
+    uint64_t _deadline;         // next deadline, 0 before the first WaitNext()
+    uint64_t _lastWake;
+    bool _started;
+    JitterStats _stats;
+};
+
+#endif
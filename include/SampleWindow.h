@@ -0,0 +1,104 @@
+/*****************************************************************************
+File name: SampleWindow.h
+Description: Fixed length window of filtered raw samples, angles are derived
+             on demand
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef SAMPLEWINDOW_H
+#define SAMPLEWINDOW_H
+
+#include <stdint.h>
+
+enum Axis {
+    AXIS_X = 0,
+    AXIS_Y = 1,
+    AXIS_Z = 2
+};
+
+/** Window of LENGTH samples stored as raw int16 X, Y, Z values plus the low
+ *  32 bits of their microsecond timestamp (10 bytes per sample). The angle
+ *  relative to each axis is computed when asked for, with the scale of the
+ *  sensor's full scale setting (LIS3DSH::CountsPerG()).
+ */
+class SampleWindow {
+  public:
+    static const int LENGTH = 20;               // one sample per 0.1s, two seconds
+    static const int16_t ANGLE_SCALE = 16;      // AngleQ4() units per degree
+
+    /** Create an empty window.
+    * @param
+    *     countsPerG raw value read at 1g
+    */
+    explicit SampleWindow(int16_t countsPerG);
+
+    /** Empties the window.
+    * @param
+    *     None
+    * @return
+    *     None
+    */
+    void Clear(void);
+
+    /** Appends a sample, ignored once the window is full.
+    * @param
+    *     x, y, z filtered raw values
+    *     timestampUs time the sample was read, SampleScheduler::Now()
+    * @return
+    *     None
+    */
+    void Push(int16_t x, int16_t y, int16_t z, uint32_t timestampUs = 0);
+
+    /** Number of samples in the window. */
+    int Size(void) const { return _size; }
+
+    /** Determines if the window holds LENGTH samples. */
+    bool Full(void) const { return _size == LENGTH; }
+
+    /** Raw value of one axis of sample i. */
+    int16_t Raw(int i, Axis axis) const { return _samples[i][axis]; }
+
+    /** Timestamp of sample i in microseconds, wraps every ~71 minutes. */
+    uint32_t Timestamp(int i) const { return _timestamps[i]; }
+
+    /** Angle between the acceleration of sample i and an axis.
+    * @param
+    *     i sample index, 0 is the oldest
+    *     axis AXIS_X, AXIS_Y or AXIS_Z
+    * @return
+    *     Angle in degrees (0.0 - 180.0), acceleration restricted to 1g.
+    */
+    float Angle(int i, Axis axis) const;
+
+    /** Angle() in fixed point, from a table, as used by extractFeatures().
+    * @param
+    *     i sample index, 0 is the oldest
+    *     axis AXIS_X, AXIS_Y or AXIS_Z
+    * @return
+    *     Angle in 1/ANGLE_SCALE degrees (0 - 180 * ANGLE_SCALE).
+    */
+    int16_t AngleQ4(int i, Axis axis) const;
+
+    /** Counts the samples whose angle relative to an axis is a strict local
+     *  maximum, each one is regarded as one repetition.
+    * @param
+    *     axis AXIS_X, AXIS_Y or AXIS_Z
+    * @return
+    *     Number of local maxima, first and last sample excluded.
+    */
+    int CountPeaks(Axis axis) const;
+
+    /** Raw value read at 1g. */
+    int16_t CountsPerG(void) const { return _countsPerG; }
+
+  private:
+    int32_t ClampG(int16_t raw) const;
+
+    int16_t _samples[LENGTH][3];
+    uint32_t _timestamps[LENGTH];
+    int16_t _countsPerG;
+    uint8_t _size;
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*****************************************************************************
+File name: SessionLog.h
+Description: Append-only, wear levelled log of fixed size CRC checked
+             records in internal flash, recovered in O(log n) at startup
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Flash as seen by the log, FlashIAP on the board and a file on the host.
+ *  Programming can only clear bits, erasing sets a whole sector to 0xFF.
+ *  All functions return 0 on success.
+ */
+class FlashDevice {
+  public:
+    virtual ~FlashDevice() {}
+    virtual int Read(uint32_t addr, void *buffer, uint32_t size) = 0;
+    virtual int Program(uint32_t addr, const void *buffer, uint32_t size) = 0;
+    virtual int Erase(uint32_t addr, uint32_t size) = 0;
+};
+
+/* record types */
+enum RecordType {
+    RECORD_SESSION = 1,         // SessionEntry
+    RECORD_CALIBRATION = 2,     // CalibrationEntry
+    RECORD_BURST = 3            // BurstEntry
+};
+
+#define LOG_RECORD_SIZE     32
+#define LOG_PAYLOAD_SIZE    20
+#define LOG_KEEP_TYPES      4           // record types that can survive rotation
+
+/** One slot of the log. */
+struct LogRecord {
+    uint32_t sequence;                  // number of records written before this one
+    uint8_t type;                       // RecordType
+    uint8_t length;                     // payload bytes used
+    uint8_t reserved[2];
+    uint8_t payload[LOG_PAYLOAD_SIZE];
+    uint32_t crc;                       // CRC-32 of the bytes above
+};
+
+/** Payload of RECORD_SESSION, one finished set of an exercise. */
+struct SessionEntry {
+    uint32_t uptimeMs;                  // end of the set, since reset
+    uint32_t durationMs;
+    uint8_t mode;                       // SESSION_FREE or SESSION_ROUTINE
+    uint8_t exercise;                   // ModelClass
+    uint16_t reps;
+};
+
+/** Payload of RECORD_CALIBRATION, accelerometer offsets applied at boot. */
+struct CalibrationEntry {
+    int8_t offset[3];                   // OFF_X, OFF_Y, OFF_Z register values
+    uint8_t reserved;
+    int16_t residual[3];                // mean error after calibration, raw counts
+};
+
+/** Payload of RECORD_BURST, summary of one triggered burst capture. */
+struct BurstEntry {
+    uint32_t uptimeMs;                  // trigger time, since reset
+    uint16_t samples;                   // pre + post samples
+    uint16_t trigger;                   // index of the trigger sample
+    uint16_t periodUs;                  // sample period
+    uint16_t peakMg;                    // largest magnitude
+    uint16_t peakJerk;                  // largest change of one axis between two samples, mg
+    uint8_t mode;                       // BurstTrigger
+    uint8_t reserved;
+};
+
+enum SessionMode {
+    SESSION_FREE = 0,
+    SESSION_ROUTINE = 1
+};
+
+/** Log structured record store over a ring of equally sized flash sectors.
+ *
+ * Slot 0 of every sector holds a header with a generation number, the erase
+ * count and the sequence number of its first record; the remaining slots are
+ * filled in order. When the active sector is full the next sector of the ring
+ * is erased and becomes active, so erases rotate evenly over all sectors.
+ *
+ * Mount() reads the sector headers to find the newest sector, then binary
+ * searches it for the first erased slot. A record torn by a reset fails its
+ * CRC and is skipped by Read().
+ *
+ * The newest record of a type registered with Keep() is never rotated out:
+ * the last slots of every sector are reserved, and before the oldest sector
+ * is erased the kept records found only there are copied into them. Two
+ * slots are reserved per kept type, so a copy torn by a reset is simply
+ * made again at the next rotation. Should resets use up the reserve, the
+ * records left are carried over in RAM and written to the new sector.
+ */
+class SessionLog {
+  public:
+    /** Create a log, nothing is read until Mount().
+    * @param
+    *     flash device holding the log
+    *     base address of the first sector
+    *     sectorSize bytes per sector
+    *     sectors number of sectors in the ring, at least 2
+    */
+    SessionLog(FlashDevice &flash, uint32_t base, uint32_t sectorSize, uint8_t sectors);
+
+    /** Finds the write position, formats the area when no valid sector exists.
+    * @param
+    *     None
+    * @return
+    *     0 on success, flash error otherwise.
+    */
+    int Mount(void);
+
+    /** Erases every sector and starts an empty log. */
+    int Format(void);
+
+    /** Keeps the newest record of a type across rotations, e.g. the
+    *   calibration. Register before the first Append().
+    * @param
+    *     type RecordType
+    * @return
+    *     0 on success, -1 when LOG_KEEP_TYPES types are kept already.
+    */
+    int Keep(uint8_t type);
+
+    /** Appends a record.
+    * @param
+    *     type RecordType
+    *     payload record contents
+    *     length payload bytes, at most LOG_PAYLOAD_SIZE
+    * @return
+    *     0 on success, -1 for a bad length, flash error otherwise.
+    */
+    int Append(uint8_t type, const void *payload, uint8_t length);
+
+    /** Reads a record by age.
+    * @param
+    *     age 0 is the newest record
+    *     record output
+    * @return
+    *     true when the record exists and its CRC is correct.
+    */
+    bool Read(uint32_t age, LogRecord *record);
+
+    /** Finds the newest valid record of a type.
+    * @param
+    *     type RecordType
+    *     record output
+    * @return
+    *     true when found.
+    */
+    bool ReadLatest(uint8_t type, LogRecord *record);
+
+    /** Number of records that can be read back. */
+    uint32_t Size(void);
+
+    /** Total number of records ever appended. */
+    uint32_t Sequence(void) const { return _firstRecord + _slot - 1; }
+
+    /** Appends left before the next one rotates the ring. */
+    uint32_t Free(void) const { return _slot < Slots() - Reserved() ? Slots() - Reserved() - _slot : 0; }
+
+    /** Erase count of the active sector. */
+    uint32_t EraseCount(void) const { return _eraseCount; }
+
+    /** Flash reads done by the last Mount(), for recovery cost measurements. */
+    uint32_t MountReads(void) const { return _mountReads; }
+
+    static uint32_t Crc32(const void *data, size_t length);
+
+  private:
+    struct SectorHeader {
+        uint32_t magic;
+        uint32_t generation;            // increments on every rotation
+        uint32_t eraseCount;
+        uint32_t firstRecord;           // sequence number of slot 1
+        uint8_t reserved[12];
+        uint32_t crc;
+    };
+
+    uint32_t SectorAddress(uint8_t sector) const { return _base + sector * _sectorSize; }
+    uint32_t Slots(void) const { return _sectorSize / LOG_RECORD_SIZE; }
+    uint32_t Reserved(void) const { return 2 * _keepCount; }
+    bool ReadHeader(uint8_t sector, SectorHeader *header);
+    int StartSector(uint8_t sector, uint32_t generation, uint32_t eraseCount, uint32_t firstRecord);
+    bool SlotErased(uint32_t slot);
+    int Rotate(void);
+    int Write(uint8_t type, const void *payload, uint8_t length);
+
+    FlashDevice &_flash;
+    uint32_t _base;
+    uint32_t _sectorSize;
+    uint8_t _sectors;
+    uint8_t _active;                    // sector being written
+    uint32_t _slot;                     // next free slot in the active sector
+    uint32_t _generation;
+    uint32_t _eraseCount;
+    uint32_t _firstRecord;
+    uint32_t _mountReads;
+    uint8_t _keep[LOG_KEEP_TYPES];      // types registered with Keep()
+    uint8_t _keepCount;
+};
+
+#endif
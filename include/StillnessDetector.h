@@ -0,0 +1,53 @@
+/*****************************************************************************
+File name: StillnessDetector.h
+Description: Decides from raw X, Y, Z samples when the board has stopped
+             moving, used instead of fixed settle times
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef STILLNESSDETECTOR_H
+#define STILLNESSDETECTOR_H
+
+#include <stdint.h>
+
+/** The board is still when the last length samples stay within range
+ *  counts of each other on every axis. Only the recent samples are kept,
+ *  so a bump restarts the count without a separate timer.
+ */
+class StillnessDetector {
+  public:
+    static const uint8_t MAX_LENGTH = 16;       // longest history
+
+    /** Create a detector.
+    * @param
+    *     length samples that must agree, 1 - MAX_LENGTH
+    *     range largest peak to peak per axis in raw counts
+    */
+    StillnessDetector(uint8_t length, uint16_t range);
+
+    /** Forgets the history, e.g. after a pause in the sampling.
+    * @param
+    *     None
+    * @return
+    *     None
+    */
+    void Reset(void);
+
+    /** Adds one raw sample.
+    * @param
+    *     x, y, z raw values from LIS3DSH::ReadData()
+    * @return
+    *     true when the last length samples, this one included, are still.
+    */
+    bool Push(int16_t x, int16_t y, int16_t z);
+
+  private:
+    int16_t _ring[MAX_LENGTH][3];
+    uint8_t _length;
+    uint8_t _count;             // samples in the ring, up to _length
+    uint8_t _index;
+    uint16_t _range;
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*****************************************************************************
+File name: BurstCapture.cpp
+Description: Event triggered capture at a high output data rate, keeps a
+             pre-trigger history and freezes the samples around a trigger
+             in fixed memory, handed off without copying
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "BurstCapture.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* a run of samples starting anywhere in a block spans at most BURST_SNAPSHOT_BLOCKS
+   blocks, and the history left over beside two snapshots and the current block */
+static const uint16_t MAX_SPAN = (BURST_SNAPSHOT_BLOCKS - 1) * BURST_BLOCK_SAMPLES;
+static const uint16_t MAX_PRE = (BURST_POOL_BLOCKS - BURST_SNAPSHOTS * BURST_SNAPSHOT_BLOCKS - 1) * BURST_BLOCK_SAMPLES;
+static_assert(MAX_PRE > 0 && BURST_POOL_BLOCKS <= 255, "BURST_POOL_BLOCKS too small or too large");
+
+BurstCapture::BurstCapture() {
+    BurstConfig config = {TRIGGER_MAGNITUDE, INT16_MAX, 0, 1, 0};
+    for (int s = 0; s < BURST_SNAPSHOTS; s++) {
+        _state[s].store(SLOT_FREE);
+    }
+    Start(config);
+}
+
+void BurstCapture::Start(const BurstConfig &config) {
+    _config = config;
+    if (_config.preSamples > MAX_PRE) {
+        _config.preSamples = MAX_PRE;
+    }
+    if (_config.preSamples > MAX_SPAN - 1) {
+        _config.preSamples = MAX_SPAN - 1;
+    }
+    if (_config.postSamples == 0) {
+        _config.postSamples = 1;
+    }
+    if (_config.preSamples + _config.postSamples > MAX_SPAN) {
+        _config.postSamples = MAX_SPAN - _config.preSamples;
+    }
+    uint32_t threshold = _config.threshold < 0 ? 0 : (uint32_t)_config.threshold;
+    _threshold2 = threshold > 65535 ? UINT32_MAX : threshold * threshold;
+
+    for (int s = 0; s < BURST_SNAPSHOTS; s++) {
+        _state[s].store(SLOT_FREE);
+    }
+    _freeCount = 0;
+    for (int b = BURST_POOL_BLOCKS - 1; b >= 0; b--) {
+        _free[_freeCount++] = (uint8_t)b;
+    }
+    _historyHead = 0;
+    _historyCount = 0;
+    _filling = -1;
+    _postLeft = 0;
+    _havePrev = false;
+    _sequence = 0;
+    _triggers = 0;
+    _dropped = 0;
+    _fill = 0;
+    NewBlock();
+}
+
+bool BurstCapture::Triggered(const int16_t *xyz) {
+    bool hit;
+
+    if (_config.trigger == TRIGGER_JERK) {
+        hit = _havePrev && (abs(xyz[0] - _prev[0]) > _config.threshold
+            || abs(xyz[1] - _prev[1]) > _config.threshold
+            || abs(xyz[2] - _prev[2]) > _config.threshold);
+    } else {
+        /* at most 3 * 32768^2, fits unsigned 32 bits */
+        uint32_t m2 = (uint32_t)(xyz[0] * xyz[0]) + (uint32_t)(xyz[1] * xyz[1]) + (uint32_t)(xyz[2] * xyz[2]);
+        hit = m2 > _threshold2;
+    }
+    _prev[0] = xyz[0];
+    _prev[1] = xyz[1];
+    _prev[2] = xyz[2];
+    _havePrev = true;
+    return hit;
+}
+
+/* takes a free block for the next samples, it joins the snapshot being filled */
+void BurstCapture::NewBlock(void) {
+    if (_freeCount == 0) {
+        /* cannot happen with the lengths fitted by Start(), lose the oldest history */
+        _free[_freeCount++] = _history[_historyHead];
+        _historyHead = (_historyHead + 1) % BURST_POOL_BLOCKS;
+        _historyCount--;
+    }
+    _current = _free[--_freeCount];
+    _fill = 0;
+    if (_filling >= 0) {
+        BurstSnapshot &snap = _snapshots[_filling];
+        _snapshotBlocks[_filling][snap.blockCount] = _current;
+        snap.blocks[snap.blockCount++] = _pool[_current];
+    }
+}
+
+/* blocks of released snapshots back to the free stack */
+void BurstCapture::Reclaim(void) {
+    for (int s = 0; s < BURST_SNAPSHOTS; s++) {
+        if (_state[s].load(std::memory_order_acquire) != SLOT_RELEASED) {
+            continue;
+        }
+        for (uint8_t b = 0; b < _snapshots[s].blockCount; b++) {
+            _free[_freeCount++] = _snapshotBlocks[s][b];
+        }
+        _state[s].store(SLOT_FREE, std::memory_order_relaxed);
+    }
+}
+
+void BurstCapture::StartSnapshot(uint32_t triggerUs) {
+    int slot = -1;
+    for (int s = 0; s < BURST_SNAPSHOTS; s++) {
+        if (_state[s].load(std::memory_order_relaxed) == SLOT_FREE) {
+            slot = s;
+            break;
+        }
+    }
+    if (slot < 0) {
+        _dropped++;
+        return;
+    }
+
+    /* the fewest history blocks that cover preSamples with the samples of _current */
+    uint16_t pre = _config.preSamples;
+    uint8_t keep = 0;
+    while (keep < _historyCount && keep * BURST_BLOCK_SAMPLES + _fill < pre) {
+        keep++;
+    }
+    while (_historyCount > keep) {
+        _free[_freeCount++] = _history[_historyHead];
+        _historyHead = (_historyHead + 1) % BURST_POOL_BLOCKS;
+        _historyCount--;
+    }
+    uint16_t available = keep * BURST_BLOCK_SAMPLES + _fill;
+    if (pre > available) {
+        pre = available;
+    }
+
+    BurstSnapshot &snap = _snapshots[slot];
+    snap.sequence = _sequence++;
+    snap.triggerUs = triggerUs;
+    snap.trigger = pre;
+    snap.samples = pre + _config.postSamples;
+    snap.first = available - pre;
+    snap.blockCount = 0;
+    for (uint8_t i = 0; i < keep; i++) {
+        uint8_t block = _history[(_historyHead + i) % BURST_POOL_BLOCKS];
+        _snapshotBlocks[slot][snap.blockCount] = block;
+        snap.blocks[snap.blockCount++] = _pool[block];
+    }
+    _snapshotBlocks[slot][snap.blockCount] = _current;
+    snap.blocks[snap.blockCount++] = _pool[_current];
+    _historyCount = 0;
+
+    _state[slot].store(SLOT_FILLING, std::memory_order_relaxed);
+    _filling = (int8_t)slot;
+    _postLeft = _config.postSamples;
+}
+
+void BurstCapture::Push(const int16_t *xyz, int n, uint32_t lastUs) {
+    Reclaim();
+    for (int i = 0; i < n; i++) {
+        const int16_t *s = xyz + 3 * i;
+        memcpy(_pool[_current][_fill], s, 3 * sizeof(int16_t));
+
+        bool hit = Triggered(s);
+        if (_filling < 0 && hit) {
+            StartSnapshot(lastUs - (uint32_t)(n - 1 - i) * _config.periodUs);
+        }
+        _fill++;
+
+        if (_filling >= 0 && --_postLeft == 0) {
+            /* complete, the rest of _current stays unused */
+            _state[_filling].store(SLOT_READY, std::memory_order_release);
+            _filling = -1;
+            _triggers++;
+            NewBlock();
+        } else if (_fill == BURST_BLOCK_SAMPLES) {
+            if (_filling < 0) {
+                _history[(_historyHead + _historyCount) % BURST_POOL_BLOCKS] = _current;
+                _historyCount++;
+                /* only as much history as preSamples needs */
+                while (_historyCount > 0 && (_historyCount - 1) * BURST_BLOCK_SAMPLES >= _config.preSamples) {
+                    _free[_freeCount++] = _history[_historyHead];
+                    _historyHead = (_historyHead + 1) % BURST_POOL_BLOCKS;
+                    _historyCount--;
+                }
+            }
+            NewBlock();
+        }
+    }
+}
+
+const BurstSnapshot *BurstCapture::Ready(void) {
+    const BurstSnapshot *oldest = NULL;
+    for (int s = 0; s < BURST_SNAPSHOTS; s++) {
+        if (_state[s].load(std::memory_order_acquire) == SLOT_READY
+            && (oldest == NULL || _snapshots[s].sequence < oldest->sequence)) {
+            oldest = &_snapshots[s];
+        }
+    }
+    return oldest;
+}
+
+void BurstCapture::Release(const BurstSnapshot *snapshot) {
+    int s = (int)(snapshot - _snapshots);
+    if (s >= 0 && s < BURST_SNAPSHOTS) {
+        _state[s].store(SLOT_RELEASED, std::memory_order_release);
+    }
+}
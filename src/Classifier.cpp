@@ -0,0 +1,86 @@
+/*****************************************************************************
+File name: Classifier.cpp
+Description: On-device exercise classifier, evaluates the quantized decision
+             tree generated by tools/train_classifier.py
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "Classifier.h"
+
+/* floor(a / b) for b > 0, C division truncates towards zero */
+static int32_t divFloor(int32_t a, int32_t b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+/* saturate, must match quantize() in tools/train_classifier.py */
+static int8_t saturate(int32_t value, int lo, int hi) {
+    if (value < lo) {
+        return (int8_t)lo;
+    }
+    if (value > hi) {
+        return (int8_t)hi;
+    }
+    return (int8_t)value;
+}
+
+/* fixed point throughout, angles in 1/ANGLE_SCALE degrees from SampleWindow::AngleQ4(),
+   every feature rounded half up to whole degrees like extract_features() in tools/train_classifier.py */
+void extractFeatures(const SampleWindow &window, int8_t features[MODEL_FEATURE_COUNT]) {
+    const int32_t scale = SampleWindow::ANGLE_SCALE;
+    int length = window.Size();
+
+    /* nothing sampled (e.g. every deadline skipped): neutral features, 90 degrees
+       on every axis and no movement */
+    if (length == 0) {
+        for (int f = 0; f < MODEL_FEATURE_COUNT; f++) {
+            features[f] = 0;
+        }
+        return;
+    }
+    int32_t sum[3] = {0, 0, 0};
+    int16_t minY = window.AngleQ4(0, AXIS_Y), maxY = minY;
+    int16_t minZ = window.AngleQ4(0, AXIS_Z), maxZ = minZ;
+
+    for (int i = 0; i < length; i++) {
+        int16_t x = window.AngleQ4(i, AXIS_X);
+        int16_t y = window.AngleQ4(i, AXIS_Y);
+        int16_t z = window.AngleQ4(i, AXIS_Z);
+        sum[0] += x;
+        sum[1] += y;
+        sum[2] += z;
+        if (y < minY) minY = y;
+        if (y > maxY) maxY = y;
+        if (z < minZ) minZ = z;
+        if (z > maxZ) maxZ = z;
+    }
+
+    /* mean angles are centred on 90 degrees to use the whole int8 range,
+       floor((sum / length - 90 * scale) / scale + 1/2) */
+    int32_t denominator = 2 * scale * length;
+    for (int a = 0; a < 3; a++) {
+        int32_t centred = 2 * (sum[a] - 90 * scale * length) + scale * length;
+        features[FEATURE_MEANX + a] = saturate(divFloor(centred, denominator), -128, 127);
+    }
+    features[FEATURE_RANGEY] = saturate((maxY - minY + scale / 2) / scale, 0, 127);
+    features[FEATURE_RANGEZ] = saturate((maxZ - minZ + scale / 2) / scale, 0, 127);
+}
+
+void classify(const int8_t features[MODEL_FEATURE_COUNT], ClassifierResult *result) {
+    uint8_t node = 0;
+
+    /* a tree of depth MODEL_MAX_DEPTH reaches a leaf after that many decisions */
+    for (int depth = 0; depth < MODEL_MAX_DEPTH && MODEL_NODES[node].feature >= 0; depth++) {
+        const ModelNode &n = MODEL_NODES[node];
+        node = (features[n.feature] <= n.threshold) ? n.left : n.right;
+    }
+
+    const uint8_t *leaf = MODEL_LEAVES[MODEL_NODES[node].left];
+    result->best = 0;
+    for (uint8_t i = 0; i < MODEL_CLASS_COUNT; i++) {
+        result->confidence[i] = leaf[i];
+        if (leaf[i] > leaf[result->best]) {
+            result->best = i;
+        }
+    }
+}
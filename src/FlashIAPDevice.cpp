@@ -0,0 +1,41 @@
+/*****************************************************************************
+File name: FlashIAPDevice.cpp
+Description: FlashDevice on the STM32 internal flash through mbed FlashIAP
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "FlashIAPDevice.h"
+
+#if DEVICE_FLASH
+
+FlashIAPDevice::FlashIAPDevice() : _ready(false) {
+}
+
+int FlashIAPDevice::Init(void) {
+    if (!_ready) {
+        int err = _flash.init();
+        if (err != 0) {
+            return err;
+        }
+        _ready = true;
+    }
+    return 0;
+}
+
+int FlashIAPDevice::Read(uint32_t addr, void *buffer, uint32_t size) {
+    int err = Init();
+    return err ? err : _flash.read(buffer, addr, size);
+}
+
+int FlashIAPDevice::Program(uint32_t addr, const void *buffer, uint32_t size) {
+    int err = Init();
+    return err ? err : _flash.program(buffer, addr, size);
+}
+
+int FlashIAPDevice::Erase(uint32_t addr, uint32_t size) {
+    int err = Init();
+    return err ? err : _flash.erase(addr, size);
+}
+
+#endif
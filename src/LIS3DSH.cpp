@@ -1,5 +1,8 @@
 #include "LIS3DSH.h"
 #include "mbed.h"
+#include <stdlib.h>
+#include <string.h>
+#include "Profiler.h"
 
 #define LIS3DSH_INFO1                       0x0D
 #define LIS3DSH_INFO2                       0x0E
@@ -13,6 +16,7 @@
 #define LIS3DSH_CTRL_REG3                   0x23
 #define LIS3DSH_CTRL_REG5                   0x24
 #define LIS3DSH_CTRL_REG6                   0x25
+#define LIS3DSH_STATUS                      0x27
 #define LIS3DSH_OUT_X_L                     0x28
 #define LIS3DSH_OUT_X_H                     0x29
 #define LIS3DSH_OUT_Y_L                     0x2A
@@ -20,26 +24,80 @@
 #define LIS3DSH_OUT_Z_L                     0x2C
 #define LIS3DSH_OUT_Z_H                     0x2D
 #define LIS3DSH_FIFO_CTRL_REG               0x2E
+#define LIS3DSH_FIFO_SRC_REG                0x2F
 
 #define LIS3DSH_READ                        0x80
 #define LIS3DSH_WRITE                       0x00
 
+#define LIS3DSH_WHO_AM_I_VALUE              0x3F
+#define LIS3DSH_STATUS_ZYXDA                0x08    // new X, Y, Z data
+#define LIS3DSH_CTRL3_STRT                  0x01    // soft reset, cleared by the part when done
+#define LIS3DSH_CTRL6_BOOT                  0x80    // reboot memory content, cleared when done
+#define LIS3DSH_CTRL6_FIFO_EN               0x40
+#define LIS3DSH_CTRL6_ADD_INC               0x10    // register address auto-increment
+#define LIS3DSH_CTRL4_ODR_SHIFT             4
+#define LIS3DSH_CTRL4_XYZ_EN                0x07
+#define LIS3DSH_FIFO_MODE_STREAM            0x40    // FMODE = 010 in FIFO_CTRL_REG
+#define LIS3DSH_FIFO_SRC_OVRN               0x40
+#define LIS3DSH_FIFO_SRC_EMPTY              0x20
+#define LIS3DSH_FIFO_SRC_FSS                0x1F
+#define LIS3DSH_CTRL5_FSCALE                0x38    // full scale field of CTRL_REG5
+#define LIS3DSH_OFFSET_STEP                 32      // counts per OFF_x LSB
+#define LIS3DSH_DATA_TIMEOUT_US             1000000 // longer than the slowest ODR period
+#define LIS3DSH_POLL_US                     100     // between two reads of a status bit
+#define LIS3DSH_RECOVERY_TIMEOUT_US         100000  // per step of the re-initialization, data waits included
+
+// sample period in microseconds per DataRate, 0 is power down
+static const uint32_t ODR_PERIOD_US[10] = {0, 320000, 160000, 80000, 40000, 20000, 10000, 2500, 1250, 625};
+
+// sensitivity in mg/digit per FullScale, datasheet typical values
+static const float MG_PER_COUNT[5] = {0.06f, 0.12f, 0.18f, 0.24f, 0.73f};
+
+static const float RAD_TO_DEG = 57.2957795f;
+static const float HALF_PI = 1.57079633f;
+static const float PI = 3.14159265f;
+
 LIS3DSH::LIS3DSH(PinName mosi, PinName miso, PinName clk, PinName cs)
-: _spi(mosi, miso, clk), _cs(cs) 
+: _fullScale(FS_2G), _dataRate(ODR_12_5HZ), _fifo(false), _gPerCount(MG_PER_COUNT[FS_2G] / 1000.0f), _repeats(0), _sinceIdentity(0),
+  _stale(false), _failed(false), _staleSinceUs(0), _detectedUs(0), _retryAtUs(0), _spi(mosi, miso, clk), _cs(cs) 
 {
+    memset(_offset, 0, sizeof(_offset));
+    memset(&_health, 0, sizeof(_health));
+    memset(_last, 0, sizeof(_last));
     
     // Make sure CS is high
     _cs = 1;
 
-    // Set up the spi interface
+    // Set up the spi interface, the sensor itself is configured by Begin()
     _spi.format(8, 3);
     _spi.frequency(1000000);
-    
+}
+
+int LIS3DSH::Begin(uint32_t timeoutUs) {
+    return Init(timeoutUs, LIS3DSH_DATA_TIMEOUT_US);
+}
+
+int LIS3DSH::Init(uint32_t timeoutUs, uint32_t dataTimeoutUs) {
+    if (!Detect(timeoutUs))
+        return -1;
+
+    // back to the reset values whatever the previous run configured, then reload the trimming
+    WriteReg(LIS3DSH_CTRL_REG3, LIS3DSH_CTRL3_STRT);
+    if (!WaitRegClear(LIS3DSH_CTRL_REG3, LIS3DSH_CTRL3_STRT, timeoutUs))
+        return -3;
+    WriteReg(LIS3DSH_CTRL_REG6, LIS3DSH_CTRL6_BOOT | LIS3DSH_CTRL6_ADD_INC);
+    if (!WaitRegClear(LIS3DSH_CTRL_REG6, LIS3DSH_CTRL6_BOOT, timeoutUs))
+        return -3;
+
     // Configure LIS3DSH
     WriteReg(LIS3DSH_CTRL_REG4, 0x5F);             // Normal power mode, all axes enabled, 50 Hz ODR
     WriteReg(LIS3DSH_CTRL_REG5, 0x80);             // 200 Hz antialias filter, +/- 2g FS range   
     WriteReg(LIS3DSH_FIFO_CTRL_REG, 0);            // configure FIFO for bypass mode   
-    WriteReg(LIS3DSH_CTRL_REG6, 0x10);             // disable FIFO, enable register address auto-increment
+    WriteReg(LIS3DSH_CTRL_REG6, LIS3DSH_CTRL6_ADD_INC);    // disable FIFO, enable register address auto-increment
+    _fullScale = FS_2G;
+    _dataRate = ODR_12_5HZ;
+    _fifo = false;
+    _gPerCount = MG_PER_COUNT[FS_2G] / 1000.0f;
 
     /* these two lines prevents lock-up of sampling according to:
     https://my.st.com/public/STe2ecommunities/mems_sensors/Lists/Accelerometers/DispForm.aspx?ID=304&Source=/public/STe2ecommunities/mems_sensors/Tags.aspx?tags=sampling
@@ -48,6 +106,11 @@ LIS3DSH::LIS3DSH(PinName mosi, PinName miso, PinName clk, PinName cs)
     */
     WriteReg(LIS3DSH_CTRL_REG4, 0x00);
     WriteReg(LIS3DSH_CTRL_REG4, 0x37);
+
+    // ready once the first conversion is latched
+    if (!WaitDataReady(dataTimeoutUs))
+        return -2;
+    return 0;
 }
 
 void LIS3DSH::WriteReg(uint8_t addr, uint8_t data) {
@@ -69,60 +132,391 @@ uint8_t LIS3DSH::ReadReg(uint8_t addr) {
 }
 
 int LIS3DSH::Detect(void) {
-    if(ReadReg(LIS3DSH_WHO_AM_I) == 0x3F)
+    if(ReadReg(LIS3DSH_WHO_AM_I) == LIS3DSH_WHO_AM_I_VALUE)
         return(1);
     else
         return(0);
 }
 
+int LIS3DSH::Detect(uint32_t timeoutUs) {
+    for (uint32_t waited = 0; ; waited += LIS3DSH_POLL_US) {
+        if (Detect())
+            return(1);
+        if (waited >= timeoutUs)
+            return(0);
+        wait_us(LIS3DSH_POLL_US);
+    }
+}
+
 void LIS3DSH::ReadData(int16_t *X, int16_t *Y, int16_t *Z) {
-    uint8_t xLSB=0, xMSB, yLSB, yMSB, zLSB, zMSB;       // 8-bit values from accelerometer
-    
-    xMSB = ReadReg(LIS3DSH_OUT_X_H);                    // read X high byte register
-    xLSB = ReadReg(LIS3DSH_OUT_X_L);                     // read X low byte register
-    yMSB = ReadReg(LIS3DSH_OUT_Y_H);
-    yLSB = ReadReg(LIS3DSH_OUT_Y_L);
-    zMSB = ReadReg(LIS3DSH_OUT_Z_H);
-    zLSB = ReadReg(LIS3DSH_OUT_Z_L);
-        
+    PROFILE_SCOPE(PROBE_READ_DATA);
+    uint8_t raw[6];                                     // X_L, X_H, Y_L, Y_H, Z_L, Z_H
+
+    // one transaction, the address auto-increments (CTRL_REG6 ADD_INC)
+    _cs = 0;
+    _spi.write(LIS3DSH_READ | LIS3DSH_OUT_X_L);
+    for (int i = 0; i < 6; i++)
+        raw[i] = _spi.write(0x00);
+    _cs = 1;
 
     //pack MSB and LSB bytes for X, Y, and Z
-    *X = (xMSB << 8) | (xLSB);   
-    *Y = (yMSB << 8) | (yLSB);
-    *Z = (zMSB << 8) | (zLSB);
+    *X = (int16_t)((raw[1] << 8) | raw[0]);
+    *Y = (int16_t)((raw[3] << 8) | raw[2]);
+    *Z = (int16_t)((raw[5] << 8) | raw[4]);
+}
+
+int LIS3DSH::ReadChecked(int16_t *X, int16_t *Y, int16_t *Z) {
+    PROFILE_SCOPE(PROBE_READ_DATA);
+    uint8_t raw[7];                                     // STATUS, X_L, X_H, Y_L, Y_H, Z_L, Z_H
+    uint32_t now = us_ticker_read();
+    bool fault = false;
+    int result = 1;
+
+    // the state of the sensor is unknown until a re-initialization succeeded
+    if (_failed) {
+        if ((int32_t)(now - _retryAtUs) >= 0)
+            result = Recover();
+        else
+            result = -2;
+        *X = _last[0];
+        *Y = _last[1];
+        *Z = _last[2];
+        return result;
+    }
+
+    // STATUS sits right before OUT_X_L, one more byte in the same burst
+    _cs = 0;
+    _spi.write(LIS3DSH_READ | LIS3DSH_STATUS);
+    for (int i = 0; i < 7; i++)
+        raw[i] = _spi.write(0x00);
+    _cs = 1;
+
+    uint8_t ones = 0xFF;
+    for (int i = 0; i < 7; i++)
+        ones &= raw[i];
+    if (ones == 0xFF) {
+        // MISO stuck high or the sensor unpowered, never a real STATUS and sample
+        _health.busErrors++;
+        fault = true;
+    } else if (!(raw[0] & LIS3DSH_STATUS_ZYXDA)) {
+        _health.staleReads++;
+        if (!_stale) {
+            _stale = true;
+            _staleSinceUs = now;
+        } else if (now - _staleSinceUs >= STALL_PERIODS * ODR_PERIOD_US[_dataRate]) {
+            _health.stalls++;
+            fault = true;
+        }
+    } else {
+        int16_t xyz[3];
+        xyz[0] = (int16_t)((raw[2] << 8) | raw[1]);
+        xyz[1] = (int16_t)((raw[4] << 8) | raw[3]);
+        xyz[2] = (int16_t)((raw[6] << 8) | raw[5]);
+        _stale = false;
+        if (xyz[0] == _last[0] && xyz[1] == _last[1] && xyz[2] == _last[2]) {
+            if (++_repeats >= FROZEN_SAMPLES) {
+                _health.frozen++;
+                fault = true;
+            }
+        } else {
+            _repeats = 0;
+        }
+        memcpy(_last, xyz, sizeof(_last));
+        result = 0;
+    }
+
+    if (!fault && ++_sinceIdentity >= IDENTITY_INTERVAL) {
+        _sinceIdentity = 0;
+        if (!Detect()) {
+            _health.identityErrors++;
+            fault = true;
+        }
+    }
+    if (fault) {
+        _detectedUs = now;
+        result = Recover();
+    }
+    else if (result == 0)
+        _health.samples++;
+
+    *X = _last[0];
+    *Y = _last[1];
+    *Z = _last[2];
+    return result;
+}
+
+// re-initializes the sensor and takes its first sample into _last, every wait bounded
+// by LIS3DSH_RECOVERY_TIMEOUT_US except the one for a sample at restored settings
+int LIS3DSH::Recover(void) {
+    PROFILE_SUSPEND(PROBE_READ_DATA);       // restart time is in Health(), not read time
+    FullScale fs = _fullScale;
+    DataRate odr = _dataRate;
+    bool fifo = _fifo;
+    int16_t *xyz = _last;
+
+    _stale = false;
+    _repeats = 0;
+    _sinceIdentity = 0;
+    // a wedged part may not even answer WHO_AM_I before a reset
+    WriteReg(LIS3DSH_CTRL_REG3, LIS3DSH_CTRL3_STRT);
+    bool ok = (Init(LIS3DSH_RECOVERY_TIMEOUT_US, LIS3DSH_RECOVERY_TIMEOUT_US) == 0);
+    if (ok && (fs != FS_2G || odr != ODR_12_5HZ || fifo || _offset[0] != 0 || _offset[1] != 0 || _offset[2] != 0)) {
+        // the latched sample predates the settings, wait for one converted with them
+        if (fs != FS_2G)
+            SetFullScale(fs);
+        if (odr != ODR_12_5HZ)
+            SetDataRate(odr);
+        SetOffsets(_offset);
+        ReadData(&xyz[0], &xyz[1], &xyz[2]);
+        // two periods at the restored rate, at least the step timeout
+        uint32_t dataUs = 2 * ODR_PERIOD_US[odr];
+        ok = WaitDataReady(dataUs > LIS3DSH_RECOVERY_TIMEOUT_US ? dataUs : LIS3DSH_RECOVERY_TIMEOUT_US);
+        if (fifo)
+            SetFifo(true);
+    }
+    if (!ok) {
+        _fullScale = fs;                                 // Begin() went back to the defaults, remembered for the retry
+        _gPerCount = MG_PER_COUNT[fs] / 1000.0f;
+        _dataRate = odr;
+        _fifo = fifo;
+        _health.failedRecoveries++;
+        _failed = true;
+        _retryAtUs = us_ticker_read() + RETRY_INTERVAL_US;
+        return -2;
+    }
+    _failed = false;
+    ReadData(&xyz[0], &xyz[1], &xyz[2]);
+
+    uint32_t latency = us_ticker_read() - _detectedUs;
+    _health.recoveries++;
+    _health.samples++;
+    _health.lastRecoveryUs = latency;
+    if (latency > _health.maxRecoveryUs)
+        _health.maxRecoveryUs = latency;
+    return -1;
 }
 
 void LIS3DSH::ReadAngles(float *Roll, float *Pitch) {   
-    int16_t Xg, Yg, Zg;                          // 16-bit values from accelerometer
+    int16_t xyz[3];                              // 16-bit values from accelerometer
 
-    //Read X, Y, Z raw values from acceleromoter     
-    ReadData(&Xg, &Yg, &Zg);
-    
-    //Convert X, Y, and Z accelerometer values to meters per second squared
-    Xg /= -141;                          
-    Zg /= -141;  // actual = 1g - raw = -1*141                         
-    Yg /= -141;
-        
-    *Roll = gToDegrees(Zg, Xg);                  // get degrees between Z and X planes
-    *Pitch = gToDegrees(Zg, Yg);                 // get degrees between Z and Y planes
+    ReadData(&xyz[0], &xyz[1], &xyz[2]);
+    ToRollPitch(xyz, Roll, Pitch, 1);
+}
+
+/* atan2 in degrees mapped to 0 - 360. The quadrant is fixed up with
+   multiplications instead of branches, so loops over it vectorize.
+   atan on [0, 1] is Abramowitz & Stegun 4.4.49, |error| < 1e-5 rad */
+static inline float atan2Degrees(float V, float H) {
+    float ax = fabsf(H), ay = fabsf(V);
+    float swap = (float)(ay > ax);
+    float left = (float)(H < 0);
+    float down = (float)(V < 0);
+    float lo = swap * ax + (1 - swap) * ay;
+    float hi = swap * ay + (1 - swap) * ax;
+    float a = lo / (hi + 1e-30f);                // 0 / 0 gives 0
+    float s = a * a;
+    float r = ((((0.0208351f * s - 0.0851330f) * s + 0.1801410f) * s - 0.3302995f) * s + 0.9998660f) * a;
+
+    r = swap * HALF_PI + (1 - 2 * swap) * r;
+    r = left * PI + (1 - 2 * left) * r;
+    r = down * 2 * PI + (1 - 2 * down) * r;
+    return r * RAD_TO_DEG;
 }
 
 float LIS3DSH::gToDegrees(float V, float H)      
 {
-  float retval;
-  uint16_t orientation=0;
-
-  if (H == 0) H = 0.001;                         // preventing division by zero
-  if (V == 0) V = 0.001;                         // preventing division by zero
-
-  if ((H > 0) && (V > 0)) orientation = 0;
-  if ((H < 0) && (V > 0)) orientation = 90; 
-  if ((H < 0) && (V < 0)) orientation = 180;
-  if ((H > 0) && (V < 0)) orientation = 270;
-
-  retval = (atan((double)V/(double)H)/3.14159)*180.0;
-  if ((double)retval < 0) 
-    retval = (double)retval + 90.0;
-  retval = fabs(retval) + orientation;
-  return retval;
-}
\ No newline at end of file
+    return atan2Degrees(V, H);
+}
+
+void LIS3DSH::ToG(const int16_t *xyz, float *out, size_t n) const {
+    const float scale = _gPerCount;
+
+    for (size_t i = 0; i < 3 * n; i++)
+        out[i] = xyz[i] * scale;
+}
+
+void LIS3DSH::ToRollPitch(const int16_t *xyz, float *roll, float *pitch, size_t n) {
+    const size_t CHUNK = 32;                     // one FIFO
+    float x[CHUNK], y[CHUNK], z[CHUNK];
+
+    // split the axes first so the angle loops run over contiguous arrays
+    for (size_t done = 0; done < n; done += CHUNK) {
+        size_t count = (n - done < CHUNK) ? n - done : CHUNK;
+        const int16_t *in = xyz + 3 * done;
+
+        // the axes point against gravity, so the acceleration is minus the reading
+        for (size_t i = 0; i < count; i++) {
+            x[i] = -(float)in[3*i];
+            y[i] = -(float)in[3*i + 1];
+            z[i] = -(float)in[3*i + 2];
+        }
+        for (size_t i = 0; i < count; i++)
+            roll[done + i] = atan2Degrees(z[i], x[i]);      // degrees between Z and X planes
+        for (size_t i = 0; i < count; i++)
+            pitch[done + i] = atan2Degrees(z[i], y[i]);     // degrees between Z and Y planes
+    }
+}
+
+void LIS3DSH::SetFullScale(FullScale fs) {
+    uint8_t ctrl5 = ReadReg(LIS3DSH_CTRL_REG5) & ~LIS3DSH_CTRL5_FSCALE;
+
+    WriteReg(LIS3DSH_CTRL_REG5, ctrl5 | ((uint8_t)fs << 3));
+    _fullScale = fs;
+    _gPerCount = MG_PER_COUNT[fs] / 1000.0f;
+}
+
+void LIS3DSH::SetDataRate(DataRate odr) {
+    WriteReg(LIS3DSH_CTRL_REG4, ((uint8_t)odr << LIS3DSH_CTRL4_ODR_SHIFT) | LIS3DSH_CTRL4_XYZ_EN);
+    _dataRate = odr;
+}
+
+uint32_t LIS3DSH::PeriodUs(DataRate odr) {
+    return ODR_PERIOD_US[odr];
+}
+
+void LIS3DSH::SetFifo(bool enable) {
+    uint8_t ctrl6 = ReadReg(LIS3DSH_CTRL_REG6);
+
+    if (enable) {
+        WriteReg(LIS3DSH_FIFO_CTRL_REG, LIS3DSH_FIFO_MODE_STREAM);
+        WriteReg(LIS3DSH_CTRL_REG6, ctrl6 | LIS3DSH_CTRL6_FIFO_EN);
+    } else {
+        WriteReg(LIS3DSH_CTRL_REG6, ctrl6 & ~LIS3DSH_CTRL6_FIFO_EN);
+        WriteReg(LIS3DSH_FIFO_CTRL_REG, 0);           // bypass, empties the FIFO
+    }
+    _fifo = enable;
+}
+
+int LIS3DSH::ReadFifo(int16_t *xyz, int maxSamples, bool *Overrun) {
+    PROFILE_SCOPE(PROBE_READ_DATA);
+    uint8_t src = ReadReg(LIS3DSH_FIFO_SRC_REG);
+    int count;
+
+    // FSS counts up to 31, a full FIFO also sets OVRN
+    if (src & LIS3DSH_FIFO_SRC_EMPTY)
+        count = 0;
+    else if (src & LIS3DSH_FIFO_SRC_OVRN)
+        count = FIFO_DEPTH;
+    else
+        count = src & LIS3DSH_FIFO_SRC_FSS;
+    if (Overrun != NULL)
+        *Overrun = (src & LIS3DSH_FIFO_SRC_OVRN) != 0;
+    if (count > maxSamples)
+        count = maxSamples;
+    if (count <= 0)
+        return 0;
+
+    // one transaction, with the FIFO on the address wraps from OUT_Z_H to OUT_X_L
+    _cs = 0;
+    _spi.write(LIS3DSH_READ | LIS3DSH_OUT_X_L);
+    for (int i = 0; i < 3 * count; i++) {
+        uint8_t lo = _spi.write(0x00);
+        uint8_t hi = _spi.write(0x00);
+        xyz[i] = (int16_t)((hi << 8) | lo);
+    }
+    _cs = 1;
+    return count;
+}
+
+int16_t LIS3DSH::CountsPerG(FullScale fs) {
+    return (int16_t)(1000.0f / MG_PER_COUNT[fs] + 0.5f);
+}
+
+void LIS3DSH::SetOffsets(const int8_t offset[3]) {
+    memcpy(_offset, offset, sizeof(_offset));
+    WriteReg(LIS3DSH_OFF_X, (uint8_t)offset[0]);
+    WriteReg(LIS3DSH_OFF_Y, (uint8_t)offset[1]);
+    WriteReg(LIS3DSH_OFF_Z, (uint8_t)offset[2]);
+}
+
+void LIS3DSH::GetOffsets(int8_t offset[3]) {
+    offset[0] = (int8_t)ReadReg(LIS3DSH_OFF_X);
+    offset[1] = (int8_t)ReadReg(LIS3DSH_OFF_Y);
+    offset[2] = (int8_t)ReadReg(LIS3DSH_OFF_Z);
+}
+
+bool LIS3DSH::WaitDataReady(uint32_t timeoutUs) {
+    for (uint32_t waited = 0; waited < timeoutUs; waited += 500) {
+        if (ReadReg(LIS3DSH_STATUS) & LIS3DSH_STATUS_ZYXDA)
+            return true;
+        wait_us(500);
+    }
+    return false;
+}
+
+bool LIS3DSH::WaitRegClear(uint8_t addr, uint8_t mask, uint32_t timeoutUs) {
+    for (uint32_t waited = 0; ; waited += LIS3DSH_POLL_US) {
+        if ((ReadReg(addr) & mask) == 0)
+            return true;
+        if (waited >= timeoutUs)
+            return false;
+        wait_us(LIS3DSH_POLL_US);
+    }
+}
+
+// averages fresh samples only, the one latched before the call is dropped
+int LIS3DSH::Average(uint16_t samples, int32_t mean[3], uint16_t spread[3]) {
+    int32_t sum[3] = {0, 0, 0};
+    int16_t lo[3] = {INT16_MAX, INT16_MAX, INT16_MAX};
+    int16_t hi[3] = {INT16_MIN, INT16_MIN, INT16_MIN};
+    int16_t xyz[3];
+
+    ReadData(&xyz[0], &xyz[1], &xyz[2]);
+    for (uint16_t n = 0; n < samples; n++) {
+        if (!WaitDataReady(LIS3DSH_DATA_TIMEOUT_US))
+            return -2;
+        ReadData(&xyz[0], &xyz[1], &xyz[2]);
+        for (int a = 0; a < 3; a++) {
+            sum[a] += xyz[a];
+            if (xyz[a] < lo[a]) lo[a] = xyz[a];
+            if (xyz[a] > hi[a]) hi[a] = xyz[a];
+        }
+    }
+    for (int a = 0; a < 3; a++) {
+        int32_t half = samples / 2;
+        mean[a] = (sum[a] >= 0 ? sum[a] + half : sum[a] - half) / samples;
+        spread[a] = (uint16_t)(hi[a] - lo[a]);
+    }
+    return 0;
+}
+
+int LIS3DSH::Calibrate(uint16_t samples, int16_t countsPerG, LIS3DSHCalibration *Result) {
+    int32_t mean[3], expected[3] = {0, 0, 0};
+    uint16_t spread[3];
+    int8_t offset[3];
+    int vertical = 0;
+    int err;
+
+    if (samples == 0)
+        samples = 1;
+
+    err = Average(samples, mean, Result->spread);
+    if (err != 0)
+        return err;
+    for (int a = 0; a < 3; a++) {
+        if (Result->spread[a] > countsPerG / 16)                  // more than ~60 mg of movement
+            return -1;
+        if (abs(mean[a]) > abs(mean[vertical]))
+            vertical = a;
+    }
+    expected[vertical] = mean[vertical] < 0 ? -countsPerG : countsPerG;
+
+    // the output already has the current offsets subtracted
+    GetOffsets(offset);
+    for (int a = 0; a < 3; a++) {
+        int32_t bias = mean[a] - expected[a];
+        int32_t step = (bias >= 0 ? bias + LIS3DSH_OFFSET_STEP/2 : bias - LIS3DSH_OFFSET_STEP/2) / LIS3DSH_OFFSET_STEP;
+        int32_t value = offset[a] + step;
+        Result->bias[a] = (int16_t)bias;
+        Result->offset[a] = (int8_t)(value > 127 ? 127 : (value < -128 ? -128 : value));
+    }
+    SetOffsets(Result->offset);
+
+    err = Average(samples, mean, spread);
+    if (err != 0)
+        return err;
+    for (int a = 0; a < 3; a++) {
+        Result->residual[a] = (int16_t)(mean[a] - expected[a]);
+    }
+    return 0;
+}
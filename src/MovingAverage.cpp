@@ -0,0 +1,54 @@
+/*****************************************************************************
+File name: MovingAverage.cpp
+Description: Moving average filter over raw X, Y, Z accelerometer samples
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "MovingAverage.h"
+#include "Profiler.h"
+
+MovingAverage::MovingAverage() {
+    Reset();
+}
+
+void MovingAverage::Reset(void) {
+    for (uint8_t i = 0; i < LENGTH; i++) {
+        _ring[i][0] = 0;
+        _ring[i][1] = 0;
+        _ring[i][2] = 0;
+    }
+    _sum[0] = 0;
+    _sum[1] = 0;
+    _sum[2] = 0;
+    _index = 0;
+}
+
+/* rounded division of a sum of LENGTH samples, back into int16 range */
+static int16_t average(int32_t sum) {
+    if (sum >= 0) {
+        return (int16_t)((sum + MovingAverage::LENGTH/2) / MovingAverage::LENGTH);
+    }
+    return (int16_t)((sum - MovingAverage::LENGTH/2) / MovingAverage::LENGTH);
+}
+
+void MovingAverage::Push(int16_t x, int16_t y, int16_t z, int16_t *fx, int16_t *fy, int16_t *fz) {
+    PROFILE_SCOPE(PROBE_FILTER);
+
+    /* replace the oldest sample in the running sums */
+    _sum[0] += x - _ring[_index][0];
+    _sum[1] += y - _ring[_index][1];
+    _sum[2] += z - _ring[_index][2];
+    _ring[_index][0] = x;
+    _ring[_index][1] = y;
+    _ring[_index][2] = z;
+
+    /* at the end of the buffer, wrap around to the beginning */
+    if (++_index >= LENGTH) {
+        _index = 0;
+    }
+
+    *fx = average(_sum[0]);
+    *fy = average(_sum[1]);
+    *fz = average(_sum[2]);
+}
@@ -0,0 +1,132 @@
+/*****************************************************************************
+File name: Profiler.cpp
+Description: Scoped hot path timers, DWT cycle counter on the board and
+             std::chrono on the host
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "Profiler.h"
+
+#ifdef PROFILER_ENABLED
+
+#include <stdio.h>
+
+#if defined(__MBED__)
+#include "mbed.h"
+#define PROFILER_UNIT "cycles"
+#else
+#include <chrono>
+#define PROFILER_UNIT "ns"
+#endif
+
+static const char *const PROBE_NAMES[PROBE_COUNT] = {
+    "ReadData", "sampling", "filter", "classify", "countReps"
+};
+
+static ProbeStats probes[PROBE_COUNT];
+static uint8_t suspendDepth[PROBE_COUNT];       // nested ProfileSuspend scopes
+static uint32_t suspensions[PROBE_COUNT];
+
+void profilerInit(void) {
+#if defined(__MBED__)
+    /* trace enable, then start the free running cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    profilerReset();
+}
+
+uint32_t profilerNow(void) {
+#if defined(__MBED__)
+    return DWT->CYCCNT;
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/* index of the highest set bit plus one, 0 for 0 */
+static uint8_t log2Bucket(uint32_t ticks) {
+    uint8_t bucket = 0;
+    while (ticks != 0 && bucket < PROFILER_BUCKETS - 1) {
+        ticks >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void profilerRecord(ProbeId id, uint32_t ticks) {
+    ProbeStats &p = probes[id];
+
+    if (suspendDepth[id] != 0) {
+        return;
+    }
+
+    if (p.count == 0 || ticks < p.min) {
+        p.min = ticks;
+    }
+    if (ticks > p.max) {
+        p.max = ticks;
+    }
+    p.count++;
+    p.total += ticks;
+
+    uint16_t &bin = p.histogram[log2Bucket(ticks)];
+    if (bin != 0xFFFF) {
+        bin++;
+    }
+}
+
+void profilerSuspend(ProbeId id) {
+    suspendDepth[id]++;
+    suspensions[id]++;
+}
+
+void profilerResume(ProbeId id) {
+    if (suspendDepth[id] != 0) {
+        suspendDepth[id]--;
+    }
+}
+
+uint32_t profilerSuspensions(ProbeId id) {
+    return suspensions[id];
+}
+
+const ProbeStats *profilerStats(ProbeId id) {
+    return &probes[id];
+}
+
+void profilerReset(void) {
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        probes[i] = ProbeStats();
+    }
+}
+
+void profilerDump(void (*print)(const char *line)) {
+    char line[96];
+
+    snprintf(line, sizeof(line), "%-10s %8s %10s %10s %10s (%s)\n",
+             "probe", "count", "min", "mean", "max", PROFILER_UNIT);
+    print(line);
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        const ProbeStats &p = probes[i];
+        if (p.count == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-10s %8lu %10lu %10lu %10lu\n", PROBE_NAMES[i],
+                 (unsigned long)p.count, (unsigned long)p.min,
+                 (unsigned long)(p.total / p.count), (unsigned long)p.max);
+        print(line);
+        for (int b = 0; b < PROFILER_BUCKETS; b++) {
+            if (p.histogram[b] == 0) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "    < 2^%-2d %8u\n", b, p.histogram[b]);
+            print(line);
+        }
+    }
+}
+
+#endif
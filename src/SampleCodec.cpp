@@ -0,0 +1,222 @@
+/*****************************************************************************
+File name: SampleCodec.cpp
+Description: Streaming lossless codec for interleaved int16 X, Y, Z samples,
+             per axis prediction + zigzag + adaptive Rice coding
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "SampleCodec.h"
+
+#define ESCAPE_LENGTH   24      // unary prefix of a residual stored raw
+#define RESIDUAL_BITS   18      // zigzag residual of a linear prediction fits
+#define MAX_K           16
+#define STATS_WINDOW    32      // sum and count are halved at this count
+
+static void resetAxis(AxisState *axis) {
+    axis->prev1 = 0;
+    axis->prev2 = 0;
+    axis->sum = 16;
+    axis->count = 1;
+}
+
+static int32_t predict(const AxisState *axis, Predictor predictor, uint16_t n) {
+    if (predictor == PREDICT_LINEAR && n >= 2) {
+        return 2 * axis->prev1 - axis->prev2;
+    }
+    return axis->prev1;
+}
+
+/* smallest k with count * 2^k >= sum, bounded by MAX_K */
+static uint8_t riceParameter(const AxisState *axis) {
+    uint8_t k = 0;
+    while (((uint32_t)axis->count << k) < axis->sum && k < MAX_K) {
+        k++;
+    }
+    return k;
+}
+
+static void update(AxisState *axis, int32_t value, uint32_t zigzag) {
+    axis->prev2 = axis->prev1;
+    axis->prev1 = value;
+    axis->sum += zigzag;
+    if (++axis->count == STATS_WINDOW) {
+        axis->sum >>= 1;
+        axis->count >>= 1;
+    }
+}
+
+/********** encoder ********************/
+
+SampleEncoder::SampleEncoder(Predictor predictor)
+: _predictor(predictor), _out(0), _capacity(0), _pos(0), _bits(0), _nbits(0), _samples(0)
+{
+}
+
+void SampleEncoder::Begin(uint8_t *out, size_t capacity) {
+    for (int a = 0; a < 3; a++) {
+        resetAxis(&_axis[a]);
+    }
+    _out = out;
+    _capacity = capacity;
+    if (_capacity > CODEC_HEADER_BYTES + 0xFFFF) {
+        _capacity = CODEC_HEADER_BYTES + 0xFFFF;    // payload size is 16 bits
+    }
+    _pos = CODEC_HEADER_BYTES;
+    _bits = 0;
+    _nbits = 0;
+    _samples = 0;
+}
+
+/* appends up to 24 bits, LSB first; room was checked by Push() */
+void SampleEncoder::PutBits(uint32_t value, uint8_t bits) {
+    _bits |= value << _nbits;
+    _nbits += bits;
+    while (_nbits >= 8) {
+        _out[_pos++] = (uint8_t)_bits;
+        _bits >>= 8;
+        _nbits -= 8;
+    }
+}
+
+bool SampleEncoder::Push(const int16_t xyz[3]) {
+    if (_out == 0 || _samples == 0xFFFF
+        || _pos * 8 + _nbits + CODEC_MAX_SAMPLE_BITS > _capacity * 8) {
+        return false;
+    }
+
+    for (int a = 0; a < 3; a++) {
+        AxisState *axis = &_axis[a];
+        int32_t value = xyz[a];
+
+        if (_samples == 0) {
+            PutBits((uint16_t)value, 16);
+            axis->prev1 = value;
+            continue;
+        }
+
+        int32_t residual = value - predict(axis, _predictor, _samples);
+        uint32_t zigzag = ((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31);
+        uint8_t k = riceParameter(axis);
+        uint32_t q = zigzag >> k;
+
+        if (q < ESCAPE_LENGTH) {
+            PutBits((1UL << q) - 1, (uint8_t)(q + 1));      // q ones and a zero
+            PutBits(zigzag & ((1UL << k) - 1), k);
+        } else {
+            PutBits((1UL << ESCAPE_LENGTH) - 1, ESCAPE_LENGTH);
+            PutBits(zigzag, RESIDUAL_BITS);
+        }
+        update(axis, value, zigzag);
+    }
+    _samples++;
+    return true;
+}
+
+size_t SampleEncoder::Finish(void) {
+    if (_out == 0) {
+        return 0;
+    }
+    if (_nbits > 0) {
+        _out[_pos++] = (uint8_t)_bits;
+        _bits = 0;
+        _nbits = 0;
+    }
+    size_t payload = _pos - CODEC_HEADER_BYTES;
+    _out[0] = (uint8_t)_samples;
+    _out[1] = (uint8_t)(_samples >> 8);
+    _out[2] = (uint8_t)payload;
+    _out[3] = (uint8_t)(payload >> 8);
+    _out[4] = (uint8_t)_predictor;
+    return _pos;
+}
+
+/********** decoder ********************/
+
+struct BitReader {
+    const uint8_t *data;
+    size_t length;
+    size_t pos;
+    uint64_t bits;
+    uint8_t nbits;
+};
+
+/* tops the reader up to at least 57 bits, past the end reads zeros */
+static void refill(BitReader *r) {
+    while (r->nbits <= 56) {
+        uint64_t byte = (r->pos < r->length) ? r->data[r->pos] : 0;
+        r->pos++;
+        r->bits |= byte << r->nbits;
+        r->nbits += 8;
+    }
+}
+
+static uint32_t getBits(BitReader *r, uint8_t bits) {
+    uint32_t value = (uint32_t)(r->bits & ((1ULL << bits) - 1));
+    r->bits >>= bits;
+    r->nbits -= bits;
+    return value;
+}
+
+int decodeBlock(const uint8_t *block, size_t length, int16_t *xyz, size_t maxSamples, size_t *used) {
+    if (length < CODEC_HEADER_BYTES) {
+        return -1;
+    }
+    uint16_t samples = (uint16_t)(block[0] | (block[1] << 8));
+    size_t payload = (size_t)(block[2] | (block[3] << 8));
+    Predictor predictor = (Predictor)block[4];
+
+    if (CODEC_HEADER_BYTES + payload > length || samples > maxSamples
+        || (predictor != PREDICT_DELTA && predictor != PREDICT_LINEAR)) {
+        return -1;
+    }
+
+    AxisState axes[3];
+    for (int a = 0; a < 3; a++) {
+        resetAxis(&axes[a]);
+    }
+    BitReader r = {block + CODEC_HEADER_BYTES, payload, 0, 0, 0};
+
+    for (uint16_t n = 0; n < samples; n++) {
+        for (int a = 0; a < 3; a++) {
+            AxisState *axis = &axes[a];
+            refill(&r);
+
+            if (n == 0) {
+                axis->prev1 = (int16_t)getBits(&r, 16);
+                xyz[a] = (int16_t)axis->prev1;
+                continue;
+            }
+
+            uint8_t k = riceParameter(axis);
+            uint64_t zeros = ~r.bits;
+            uint32_t ones = zeros ? (uint32_t)__builtin_ctzll(zeros) : 64;
+            uint32_t zigzag;
+            if (ones < ESCAPE_LENGTH) {
+                getBits(&r, (uint8_t)(ones + 1));
+                zigzag = (ones << k) | getBits(&r, k);
+            } else {
+                getBits(&r, ESCAPE_LENGTH);
+                zigzag = getBits(&r, RESIDUAL_BITS);
+            }
+
+            int32_t residual = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            int32_t value = predict(axis, predictor, n) + residual;
+            if (value < -32768 || value > 32767) {
+                return -1;
+            }
+            xyz[a] = (int16_t)value;
+            update(axis, value, zigzag);
+        }
+        xyz += 3;
+    }
+
+    /* bits consumed, the payload must have held them */
+    if (r.pos * 8 - r.nbits > payload * 8) {
+        return -1;
+    }
+    if (used != 0) {
+        *used = CODEC_HEADER_BYTES + payload;
+    }
+    return samples;
+}
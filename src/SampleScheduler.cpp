@@ -0,0 +1,82 @@
+/*****************************************************************************
+File name: SampleScheduler.cpp
+Description: Fixed rate sampling on an absolute deadline grid, with
+             monotonic timestamps, jitter statistics and missed deadlines
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "SampleScheduler.h"
+#include "mbed.h"
+
+SampleScheduler::SampleScheduler(uint32_t periodUs)
+: _periodUs(periodUs), _deadline(0), _lastWake(0), _started(false)
+{
+    ResetStats();
+}
+
+uint64_t SampleScheduler::Now(void) {
+    /* the HAL keeps the 64 bit count across wraps, however rarely this is called */
+    return ticker_read_us(get_us_ticker_data());
+}
+
+void SampleScheduler::Start(void) {
+    _deadline = Now();
+    _started = false;
+}
+
+void SampleScheduler::ResetStats(void) {
+    _stats.samples = 0;
+    _stats.missed = 0;
+    _stats.minLateUs = UINT32_MAX;
+    _stats.maxLateUs = 0;
+    _stats.sumLateUs = 0;
+    _stats.minIntervalUs = UINT32_MAX;
+    _stats.maxIntervalUs = 0;
+}
+
+uint32_t SampleScheduler::WaitNext(uint64_t *timestampUs) {
+    uint32_t missed = 0;
+    uint64_t now = Now();
+    bool first = !_started;             // no interval across the pause before Start()
+
+    if (_started) {
+        _deadline += _periodUs;
+    }
+    _started = true;
+
+    /* already past one or more deadlines, skip them and stay on the grid */
+    if (now >= _deadline + _periodUs) {
+        missed = (uint32_t)((now - _deadline) / _periodUs);
+        _deadline += (uint64_t)missed * _periodUs;
+        _stats.missed += missed;
+    }
+
+    /* sleep all but the last millisecond (tick granularity), then wait out the rest */
+    if (_deadline > now) {
+        uint64_t remaining = _deadline - now;
+        if (remaining >= 2000) {
+            thread_sleep_for((uint32_t)(remaining / 1000) - 1);
+        }
+        now = Now();
+        if (_deadline > now) {
+            wait_us((int)(_deadline - now));
+        }
+        now = Now();
+    }
+
+    uint32_t late = (uint32_t)(now - _deadline);
+    if (late < _stats.minLateUs) _stats.minLateUs = late;
+    if (late > _stats.maxLateUs) _stats.maxLateUs = late;
+    _stats.sumLateUs += late;
+    if (!first && missed == 0) {
+        uint32_t interval = (uint32_t)(now - _lastWake);
+        if (interval < _stats.minIntervalUs) _stats.minIntervalUs = interval;
+        if (interval > _stats.maxIntervalUs) _stats.maxIntervalUs = interval;
+    }
+    _stats.samples++;
+    _lastWake = now;
+
+    *timestampUs = now;
+    return missed;
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************
+File name: SampleWindow.cpp
+Description: Fixed length window of filtered raw samples, angles are derived
+             on demand
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "SampleWindow.h"
+#include "Profiler.h"
+#include <math.h>
+
+static const float PI = 3.1415926;
+
+/* acos(i / ACOS_STEPS) in 1/16 degree, rounded half up, 0 <= i <= ACOS_STEPS;
+   must match acos_table() in tools/train_classifier.py */
+#define ACOS_STEPS 256
+static const uint16_t ACOS_Q4[ACOS_STEPS + 1] = {
+    1440, 1436, 1433, 1429, 1426, 1422, 1419, 1415, 1411, 1408, 1404, 1401,
+    1397, 1393, 1390, 1386, 1383, 1379, 1375, 1372, 1368, 1365, 1361, 1358,
+    1354, 1350, 1347, 1343, 1340, 1336, 1332, 1329, 1325, 1321, 1318, 1314,
+    1311, 1307, 1303, 1300, 1296, 1293, 1289, 1285, 1282, 1278, 1274, 1271,
+    1267, 1263, 1260, 1256, 1252, 1249, 1245, 1241, 1238, 1234, 1230, 1227,
+    1223, 1219, 1216, 1212, 1208, 1205, 1201, 1197, 1194, 1190, 1186, 1182,
+    1179, 1175, 1171, 1167, 1164, 1160, 1156, 1152, 1149, 1145, 1141, 1137,
+    1134, 1130, 1126, 1122, 1118, 1114, 1111, 1107, 1103, 1099, 1095, 1091,
+    1088, 1084, 1080, 1076, 1072, 1068, 1064, 1060, 1056, 1053, 1049, 1045,
+    1041, 1037, 1033, 1029, 1025, 1021, 1017, 1013, 1009, 1005, 1001, 997,
+    993, 989, 985, 981, 976, 972, 968, 964, 960, 956, 952, 948,
+    943, 939, 935, 931, 927, 922, 918, 914, 910, 905, 901, 897,
+    892, 888, 884, 879, 875, 871, 866, 862, 857, 853, 848, 844,
+    839, 835, 830, 826, 821, 816, 812, 807, 803, 798, 793, 789,
+    784, 779, 774, 769, 765, 760, 755, 750, 745, 740, 735, 730,
+    725, 720, 715, 710, 705, 700, 694, 689, 684, 679, 673, 668,
+    663, 657, 652, 646, 641, 635, 629, 624, 618, 612, 606, 601,
+    595, 589, 583, 577, 571, 564, 558, 552, 545, 539, 533, 526,
+    519, 513, 506, 499, 492, 485, 478, 471, 463, 456, 448, 441,
+    433, 425, 417, 409, 400, 392, 383, 374, 365, 355, 346, 336,
+    326, 315, 305, 293, 282, 270, 257, 244, 230, 215, 199, 181,
+    162, 140, 115, 81, 0,
+};
+
+SampleWindow::SampleWindow(int16_t countsPerG)
+: _countsPerG(countsPerG)
+{
+    Clear();
+}
+
+/* restrict to 1g (acceleration not decoupled from orientation) */
+int32_t SampleWindow::ClampG(int16_t raw) const {
+    if (raw > _countsPerG) {
+        return _countsPerG;
+    }
+    if (raw < -_countsPerG) {
+        return -_countsPerG;
+    }
+    return raw;
+}
+
+void SampleWindow::Clear(void) {
+    _size = 0;
+}
+
+void SampleWindow::Push(int16_t x, int16_t y, int16_t z, uint32_t timestampUs) {
+    if (_size >= LENGTH) {
+        return;
+    }
+    _samples[_size][AXIS_X] = x;
+    _samples[_size][AXIS_Y] = y;
+    _samples[_size][AXIS_Z] = z;
+    _timestamps[_size] = timestampUs;
+    _size++;
+}
+
+float SampleWindow::Angle(int i, Axis axis) const {
+    float g = (float)ClampG(_samples[i][axis]) / _countsPerG;
+    return 180*acosf(g)/PI;
+}
+
+/* table lookup with linear interpolation, no floating point; the error is
+   below 0.1 degree up to 0.996g and at most 1.3 degrees beyond it */
+int16_t SampleWindow::AngleQ4(int i, Axis axis) const {
+    int32_t raw = ClampG(_samples[i][axis]);
+    uint32_t g = ((uint32_t)(raw < 0 ? -raw : raw) << 16) / (uint32_t)_countsPerG;   // 1g = 1 << 16
+    uint32_t index = g >> 8;
+    int32_t angle = ACOS_Q4[index];
+
+    if (index < ACOS_STEPS) {
+        angle -= ((angle - ACOS_Q4[index + 1]) * (int32_t)(g & 0xFF) + 128) >> 8;
+    }
+    return (int16_t)(raw < 0 ? 180 * ANGLE_SCALE - angle : angle);
+}
+
+int SampleWindow::CountPeaks(Axis axis) const {
+    PROFILE_SCOPE(PROBE_COUNT_REPS);
+    int peaks = 0;
+
+    /* acos is decreasing, so a maximum of the angle is a minimum of the raw value */
+    for (int i = 1; i < _size - 1; i++) {
+        int32_t v = ClampG(_samples[i][axis]);
+        if (v < ClampG(_samples[i-1][axis]) && v < ClampG(_samples[i+1][axis])) {
+            peaks++;
+        }
+    }
+    return peaks;
+}
@@ -0,0 +1,258 @@
+/*****************************************************************************
+File name: SessionLog.cpp
+Description: Append-only, wear levelled log of fixed size CRC checked
+             records in internal flash, recovered in O(log n) at startup
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "SessionLog.h"
+#include <string.h>
+
+#define SECTOR_MAGIC    0x4C535345      // "ESSL"
+
+SessionLog::SessionLog(FlashDevice &flash, uint32_t base, uint32_t sectorSize, uint8_t sectors)
+: _flash(flash), _base(base), _sectorSize(sectorSize), _sectors(sectors), _active(0),
+  _slot(1), _generation(0), _eraseCount(0), _firstRecord(0), _mountReads(0), _keepCount(0)
+{
+}
+
+/* CRC-32 (IEEE), 4 bits at a time to keep the table at 64 bytes */
+uint32_t SessionLog::Crc32(const void *data, size_t length) {
+    static const uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ TABLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+bool SessionLog::ReadHeader(uint8_t sector, SectorHeader *header) {
+    if (_flash.Read(SectorAddress(sector), header, sizeof(*header)) != 0) {
+        return false;
+    }
+    return header->magic == SECTOR_MAGIC
+        && header->crc == Crc32(header, sizeof(*header) - sizeof(header->crc));
+}
+
+int SessionLog::StartSector(uint8_t sector, uint32_t generation, uint32_t eraseCount, uint32_t firstRecord) {
+    SectorHeader header;
+
+    int err = _flash.Erase(SectorAddress(sector), _sectorSize);
+    if (err != 0) {
+        return err;
+    }
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = SECTOR_MAGIC;
+    header.generation = generation;
+    header.eraseCount = eraseCount;
+    header.firstRecord = firstRecord;
+    header.crc = Crc32(&header, sizeof(header) - sizeof(header.crc));
+    err = _flash.Program(SectorAddress(sector), &header, sizeof(header));
+    if (err != 0) {
+        return err;
+    }
+
+    _active = sector;
+    _slot = 1;
+    _generation = generation;
+    _eraseCount = eraseCount;
+    _firstRecord = firstRecord;
+    return 0;
+}
+
+bool SessionLog::SlotErased(uint32_t slot) {
+    uint32_t words[LOG_RECORD_SIZE / 4];
+
+    _mountReads++;
+    if (_flash.Read(SectorAddress(_active) + slot * LOG_RECORD_SIZE, words, sizeof(words)) != 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < LOG_RECORD_SIZE / 4; i++) {
+        if (words[i] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int SessionLog::Format(void) {
+    for (uint8_t s = 1; s < _sectors; s++) {
+        int err = _flash.Erase(SectorAddress(s), _sectorSize);
+        if (err != 0) {
+            return err;
+        }
+    }
+    return StartSector(0, 1, 1, 0);
+}
+
+int SessionLog::Mount(void) {
+    SectorHeader header;
+    bool found = false;
+
+    /* sector index: the valid header with the highest generation is active */
+    _mountReads = 0;
+    for (uint8_t s = 0; s < _sectors; s++) {
+        _mountReads++;
+        if (ReadHeader(s, &header) && (!found || header.generation > _generation)) {
+            found = true;
+            _active = s;
+            _generation = header.generation;
+            _eraseCount = header.eraseCount;
+            _firstRecord = header.firstRecord;
+        }
+    }
+    if (!found) {
+        return Format();
+    }
+
+    /* slots are filled in order, so the first erased one is found by bisection */
+    uint32_t lo = 1, hi = Slots();
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (SlotErased(mid)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    _slot = lo;
+    return 0;
+}
+
+int SessionLog::Keep(uint8_t type) {
+    for (uint8_t i = 0; i < _keepCount; i++) {
+        if (_keep[i] == type) {
+            return 0;
+        }
+    }
+    if (_keepCount >= LOG_KEEP_TYPES) {
+        return -1;
+    }
+    _keep[_keepCount++] = type;
+    return 0;
+}
+
+int SessionLog::Rotate(void) {
+    SectorHeader header;
+    LogRecord record;
+    LogRecord pending[LOG_KEEP_TYPES];  // kept records without a slot left
+    uint8_t pendingCount = 0;
+    uint8_t next = (_active + 1) % _sectors;
+    bool valid = ReadHeader(next, &header);
+    uint32_t eraseCount = valid ? header.eraseCount : 0;
+
+    /* the next sector holds the oldest records of the ring, copy the kept ones only
+       found there into the reserved slots first, so a reset during the erase loses nothing */
+    if (valid && header.generation + _sectors - 1 == _generation) {
+        uint32_t first = header.firstRecord;
+        for (uint8_t i = 0; i < _keepCount; i++) {
+            if (ReadLatest(_keep[i], &record) && record.sequence >= first
+                && record.sequence < first + Slots() - 1) {
+                if (_slot >= Slots()) {
+                    /* resets during earlier copies used up the reserve,
+                       carry the record over in RAM as a last resort */
+                    pending[pendingCount++] = record;
+                    continue;
+                }
+                int err = Write(record.type, record.payload, record.length);
+                if (err != 0) {
+                    return err;
+                }
+            }
+        }
+    }
+    int err = StartSector(next, _generation + 1, eraseCount + 1, _firstRecord + Slots() - 1);
+    for (uint8_t i = 0; i < pendingCount && err == 0; i++) {
+        err = Write(pending[i].type, pending[i].payload, pending[i].length);
+    }
+    return err;
+}
+
+int SessionLog::Append(uint8_t type, const void *payload, uint8_t length) {
+    if (length > LOG_PAYLOAD_SIZE) {
+        return -1;
+    }
+    if (_slot >= Slots() - Reserved()) {
+        int err = Rotate();
+        if (err != 0) {
+            return err;
+        }
+    }
+    return Write(type, payload, length);
+}
+
+/* programs the next slot, the caller checked that one is left */
+int SessionLog::Write(uint8_t type, const void *payload, uint8_t length) {
+    LogRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.sequence = Sequence();
+    record.type = type;
+    record.length = length;
+    memcpy(record.payload, payload, length);
+    record.crc = Crc32(&record, sizeof(record) - sizeof(record.crc));
+
+    int err = _flash.Program(SectorAddress(_active) + _slot * LOG_RECORD_SIZE, &record, sizeof(record));
+    _slot++;                            // a failed slot is never reused, Read() skips it
+    return err;
+}
+
+bool SessionLog::Read(uint32_t age, LogRecord *record) {
+    uint8_t sector = _active;
+    uint32_t generation = _generation;
+    uint32_t used = _slot - 1;          // records in the sector being looked at
+    SectorHeader header;
+
+    /* walk back through older sectors of the same, unbroken ring */
+    while (age >= used) {
+        age -= used;
+        sector = (sector + _sectors - 1) % _sectors;
+        if (sector == _active || !ReadHeader(sector, &header) || header.generation != generation - 1) {
+            return false;
+        }
+        generation--;
+        used = Slots() - 1;
+    }
+
+    uint32_t slot = used - age;
+    if (_flash.Read(SectorAddress(sector) + slot * LOG_RECORD_SIZE, record, sizeof(*record)) != 0) {
+        return false;
+    }
+    return record->crc == Crc32(record, sizeof(*record) - sizeof(record->crc));
+}
+
+bool SessionLog::ReadLatest(uint8_t type, LogRecord *record) {
+    uint32_t size = Size();
+
+    for (uint32_t age = 0; age < size; age++) {
+        if (Read(age, record) && record->type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t SessionLog::Size(void) {
+    uint32_t size = _slot - 1;
+    uint32_t generation = _generation;
+    uint8_t sector = _active;
+    SectorHeader header;
+
+    for (uint8_t i = 1; i < _sectors; i++) {
+        sector = (sector + _sectors - 1) % _sectors;
+        if (!ReadHeader(sector, &header) || header.generation != generation - 1) {
+            break;
+        }
+        generation--;
+        size += Slots() - 1;
+    }
+    return size;
+}
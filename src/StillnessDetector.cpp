@@ -0,0 +1,48 @@
+/*****************************************************************************
+File name: StillnessDetector.cpp
+Description: Decides from raw X, Y, Z samples when the board has stopped
+             moving, used instead of fixed settle times
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "StillnessDetector.h"
+
+StillnessDetector::StillnessDetector(uint8_t length, uint16_t range)
+: _length(length == 0 ? 1 : (length > MAX_LENGTH ? MAX_LENGTH : length)), _range(range)
+{
+    Reset();
+}
+
+void StillnessDetector::Reset(void) {
+    _count = 0;
+    _index = 0;
+}
+
+bool StillnessDetector::Push(int16_t x, int16_t y, int16_t z) {
+    _ring[_index][0] = x;
+    _ring[_index][1] = y;
+    _ring[_index][2] = z;
+    if (++_index >= _length) {
+        _index = 0;
+    }
+    if (_count < _length) {
+        _count++;
+    }
+    if (_count < _length) {
+        return false;
+    }
+
+    /* at most MAX_LENGTH samples, a full scan is cheaper than tracking extremes */
+    for (int a = 0; a < 3; a++) {
+        int16_t lo = _ring[0][a], hi = _ring[0][a];
+        for (uint8_t i = 1; i < _length; i++) {
+            if (_ring[i][a] < lo) lo = _ring[i][a];
+            if (_ring[i][a] > hi) hi = _ring[i][a];
+        }
+        if ((int32_t)hi - lo > _range) {
+            return false;
+        }
+    }
+    return true;
+}
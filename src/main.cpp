@@ -12,6 +12,18 @@ Date: 12/16/2020
 
 /* user imports */
 #include "LIS3DSH.h"
+#include "Classifier.h"
+#include "Profiler.h"
+#include "SampleScheduler.h"
+#include "SessionLog.h"
+#include "FlashIAPDevice.h"
+#include "MovingAverage.h"
+#include "SampleWindow.h"
+#include "SampleCodec.h"
+#include "Exercise.h"
+#include "StillnessDetector.h"
+#include "BurstCapture.h"
+#include "PipelineStages.h"
 
 /* USBSerial library for serial terminal */
 USBSerial serial(0x1f00,0x2012,0x0001,false);
@@ -24,6 +36,7 @@ DigitalOut MyLED6(LED6);					// LED6 - blue - stands for JumpJacks
 DigitalOut MyLED4(LED4);					// LED4 - green - stands for Squarts
 DigitalOut MyLED3(LED3);					// LED3 - orange - stands for SitUps
 DigitalOut MyLED5(LED5);					// LED5 - red - stands for PushUps
+DigitalOut *const LEDS[] = {&MyLED3, &MyLED4, &MyLED5, &MyLED6};	// indexed by ExerciseLed
 
 /* Button input */
 DigitalIn MyButton(BUTTON1);				// User Button to receive user interrupts
@@ -31,388 +44,552 @@ DigitalIn MyButton(BUTTON1);				// User Button to receive user interrupts
 /* Final variables */
 const int VERY_SHORT_TIME = 200;			// to control fast blinking
 const int SHORT_TIME = 500;					// to control blink frequency
-const int LONG_TIME = 3000;					// to wait for user input
+const int LONG_TIME = 3000;					// longest settle time before a mode starts
 const int ON = 1;							// ON state of LED and User Button 
 const int OFF = 0;							// OFF state of LED and User Button 
-const float PI = 3.1415926;					// PI		
-const int PRESAMPLE_LENGTH = 20;			// presample length
+const int DEFER_LIMIT = 3;					// windows in a row after which the best class is accepted anyway
+const uint32_t SAMPLE_PERIOD_US = 100000;	// one sample per 0.1s
+const uint32_t LOG_BASE = 0x080A0000;		// session log in flash sectors 9 - 11,
+const uint32_t LOG_SECTOR_SIZE = 0x20000;	// keep the firmware below LOG_BASE (platformio.ini)
+const uint8_t LOG_SECTORS = 3;
+const uint16_t CAPTURE_BLOCK = 64;			// samples per encoded capture block
+const uint16_t CALIBRATION_SAMPLES = 50;	// samples averaged by the offset calibration
+const uint32_t BOOT_TIMEOUT_US = 100000;	// per accelerometer start attempt and reset step
+const int BOOT_ATTEMPTS = 5;				// failed starts after which the red LED blinks
+const uint8_t STILL_SAMPLES = 5;			// samples in a row (0.5s) that must agree to be still
+const uint16_t STILL_RANGE = 500;			// peak to peak per axis while still, about 30 mg at +/- 2g
+const uint16_t BURST_PRE_MS = 100;			// kept before a burst trigger
+const uint16_t BURST_POST_MS = 100;			// taken after a burst trigger
+const int BURST_TRIGGER_MG = 2000;			// magnitude that triggers a burst, e.g. the landing of a jump
+const int BURST_POLL_MS = 10;				// between two FIFO reads, the FIFO holds 20 ms at 1.6 kHz
+const int BURST_QUEUE = 16;					// burst summaries kept until the capture ends
 
 /* Internal variables */
 bool isButtonPressed = false;				// button state
-int16_t xAccel = 0;							// acceleration in x (raw)
-int16_t yAccel = 0;							// acceleration in y (raw)
-int16_t zAccel = 0; 						// acceleration in z (raw)
-float g_x = 0;  							// acceleration in x 
-float g_y = 0; 								// acceleration in y
-float g_z = 0;  							// acceleration in z 
-float angleX = 0;							// angle relative to x axis
-float angleY = 0;							// angle relative to y axis
-float angleZ = 0;							// angle relative to z axis
-double presamplesBuffer[PRESAMPLE_LENGTH][3];	// buffer storing preSamples
-double tempBuffer[3];						// intermedia buffer
-
-/* Filter Parameters  */
-const uint8_t N = 20; 						// filter length
-float ringbufX[N];							// sample buffer x
-float ringbufY[N];							// sample buffer y
-float ringbufZ[N];							// sample buffer z
-uint8_t ringbuf_index_x = 0;				// index to insert sample x
-uint8_t ringbuf_index_y = 0;				// index to insert sample y
-uint8_t ringbuf_index_z = 0;				// index to insert sample z
+MovingAverage filter;						// moving average over the raw samples
+SampleWindow presamples(acc.CountsPerG());	// window of presampled data
+Pipeline<ReadStage, FilterStage, WindowStage> acquisition =
+	makePipeline(ReadStage(acc), FilterStage(filter), WindowStage(presamples));	// read -> moving average -> presamples
+SampleScheduler scheduler(SAMPLE_PERIOD_US);	// deadline grid of the samples
+FlashIAPDevice flash;						// internal flash
+SessionLog sessionLog(flash, LOG_BASE, LOG_SECTOR_SIZE, LOG_SECTORS);	// results kept across resets
+bool logReady = false;						// sessionLog mounted
+uint8_t captureBuffer[CODEC_MAX_BLOCK_BYTES(CAPTURE_BLOCK)];	// one encoded capture block
+StillnessDetector stillness(STILL_SAMPLES, STILL_RANGE);	// ends the settle time
+BurstCapture burst;							// pre-trigger history and snapshots of captureBurst()
+int16_t fifoSamples[LIS3DSH::FIFO_DEPTH * 3];	// one FIFO read
+BurstEntry burstQueue[BURST_QUEUE];			// summaries of captureBurst(), printed and logged after the FIFO loop
+uint32_t burstQueueSequence[BURST_QUEUE];	// snapshot number of each summary
+uint32_t mainUs = 0;						// reset to main(), the us ticker starts in mbed's HAL_Init()
+uint32_t firstSampleUs = 0;					// reset to the first sample of the accelerometer
+int bootFailures = 0;						// accelerometer starts that failed before the first sample
+uint64_t modeStartUs = 0;					// button press that started the current mode
+uint32_t firstClassificationUs = 0;			// button press to the first classification of the last free exercise
+uint32_t settleMs = 0;						// last settle time
 
 
 /*************************************************
-Function: sampling
-Description: Code modified from TA Michael's demo, used to sample one data on each axis
+Function: serialPrint
+Description: writes one line to the serial terminal
 Calls: None
-Called By: sampleTwoSeconds()
-Others: store the sampled data in tempBuffer
+Called By: serialCommands()
+Others: used as the output of the dump functions
 *************************************************/
-void sampling() {
-	/* read data from the accelerometer */
-	acc.ReadData(&xAccel, &yAccel, &zAccel);
-
-	/* normalise to 1g */
-	g_x = (float)xAccel/17694.0;
-	g_y = (float)yAccel/17694.0;
-	g_z = (float)zAccel/17694.0;
-
-	/* insert in to circular buffer */
-	ringbufX[ringbuf_index_x++] = g_x;
-	ringbufY[ringbuf_index_y++] = g_y;
-	ringbufZ[ringbuf_index_z++] = g_z;
-
-	/* at the end of the buffer, wrap around to the beginning */
-	if (ringbuf_index_x >= N) {
-		ringbuf_index_x = 0;
-	}
-	if (ringbuf_index_y >= N) {
-		ringbuf_index_y = 0;
-	}
-	if (ringbuf_index_z >= N) {
-		ringbuf_index_z = 0;
-	}
+void serialPrint(const char *line) {
+	serial.printf("%s", line);
+}
 
-	/********** START of filtering ********************/
-	float g_x_filt = 0;
-	float g_y_filt = 0;
-	float g_z_filt = 0;
 
-	/* add all samples */
-	for (uint8_t i = 0; i < N; i++) {
-		g_x_filt += ringbufX[i];
-	}
-	for (uint8_t i = 0; i < N; i++) {
-		g_y_filt += ringbufY[i];
-	}
-	for (uint8_t i = 0; i < N; i++) {
-		g_z_filt += ringbufZ[i];
+/*************************************************
+Function: logSession
+Description: appends a finished set to the session log
+Calls: None
+Called By: routinedExercise(), freeToExercise()
+Others: startUs is SampleScheduler::Now() when the set started
+*************************************************/
+void logSession(uint8_t mode, uint8_t exercise, int reps, uint64_t startUs) {
+	SessionEntry entry;
+	uint64_t now = SampleScheduler::Now();
+
+	entry.uptimeMs = (uint32_t)(now / 1000);
+	entry.durationMs = (uint32_t)((now - startUs) / 1000);
+	entry.mode = mode;
+	entry.exercise = exercise;
+	entry.reps = (uint16_t)reps;
+	if (!logReady || sessionLog.Append(RECORD_SESSION, &entry, sizeof(entry)) != 0) {
+		serial.printf("Could not log session\r\n");
 	}
+}
 
-	/* divide by number of samples */
-	g_x_filt /= (float)N;
-	g_y_filt /= (float)N;
-	g_z_filt /= (float)N;
-	/* restrict to 1g (acceleration not decoupled from orientation) */
-	if (g_x_filt > 1) {
-		g_x_filt = 1;
-	}
-	if (g_y_filt > 1) {
-		g_y_filt = 1;
-	}
-	if (g_z_filt > 1) {
-		g_z_filt = 1;
+
+/*************************************************
+Function: printSessions
+Description: prints the latest sessions of the log, newest first
+Calls: None
+Called By: serialCommands()
+Others: 
+*************************************************/
+void printSessions(uint32_t count) {
+	LogRecord record;
+	SessionEntry entry;
+	uint32_t size = logReady ? sessionLog.Size() : 0;
+
+	serial.printf("%lu records, sector erased %lu times\r\n",
+		(unsigned long)sessionLog.Sequence(), (unsigned long)sessionLog.EraseCount());
+	for (uint32_t age = 0; age < size && count > 0; age++) {
+		if (!sessionLog.Read(age, &record) || record.type != RECORD_SESSION) {
+			continue;
+		}
+		memcpy(&entry, record.payload, sizeof(entry));
+		serial.printf("#%lu %s %s %u reps in %lu s\r\n", (unsigned long)record.sequence,
+			entry.mode == SESSION_ROUTINE ? "routine" : "free",
+			entry.exercise < MODEL_CLASS_COUNT ? MODEL_CLASS_NAMES[entry.exercise] : "?",
+			entry.reps, (unsigned long)(entry.durationMs / 1000));
+		count--;
 	}
-	/********** END of filtering **********************/
+}
 
-	/* compute angle in degrees */
-	angleX = 180*acos(g_x_filt)/PI;
-	angleY = 180*acos(g_y_filt)/PI;
-	angleZ = 180*acos(g_z_filt)/PI;
 
-	/* Storing the sampling result */
-	tempBuffer[0] = angleX;
-	tempBuffer[1] = angleY;
-	tempBuffer[2] = angleZ;
+/*************************************************
+Function: loadCalibration
+Description: programs the accelerometer offsets kept in the session log
+Calls: None
+Called By: main()
+Others: the sensor keeps its reset offsets (0) until the first calibration
+*************************************************/
+void loadCalibration() {
+	LogRecord record;
+	CalibrationEntry entry;
+
+	if (logReady && sessionLog.ReadLatest(RECORD_CALIBRATION, &record)) {
+		memcpy(&entry, record.payload, sizeof(entry));
+		acc.SetOffsets(entry.offset);
+	}
 }
 
 
 /*************************************************
-Function: sampleTwoSeconds
-Description: sampling for two seconds
-Calls: sampling()
-Called By: routinedExercise(), freeToExercise()
-Others: store the sampled data in presamplesBuffer
+Function: calibrate
+Description: measures the zero-g bias, corrects it in the sensor and stores the offsets
+Calls: None
+Called By: serialCommands()
+Others: 
+
+the board must lie flat and still for about 8 seconds,
+biases and residual errors are printed in raw counts
 *************************************************/
-void sampleTwoSeconds() {
-    /* one sampel per 0.1s, so for two seconds, we need 20 times, which is PRESAMPLE_LENGTH */
-    for (int i = 0; i < PRESAMPLE_LENGTH; i++) {
-		sampling();
-        presamplesBuffer[i][0] = tempBuffer[0];
-		presamplesBuffer[i][1] = tempBuffer[1];
-		presamplesBuffer[i][2] = tempBuffer[2];
-		wait_ms(100);
-    }
+void calibrate() {
+	LIS3DSHCalibration result;
+	CalibrationEntry entry;
+
+	serial.printf("Calibrating, keep the board flat and still\r\n");
+	int err = acc.Calibrate(CALIBRATION_SAMPLES, acc.CountsPerG(), &result);
+	if (err == -1) {
+		serial.printf("Board moved (spread %u %u %u), try again\r\n",
+			result.spread[0], result.spread[1], result.spread[2]);
+		return;
+	} else if (err != 0) {
+		serial.printf("No data from the accelerometer\r\n");
+		return;
+	}
+	serial.printf("bias %d %d %d, residual %d %d %d, offsets %d %d %d\r\n",
+		result.bias[0], result.bias[1], result.bias[2],
+		result.residual[0], result.residual[1], result.residual[2],
+		result.offset[0], result.offset[1], result.offset[2]);
+
+	memcpy(entry.offset, result.offset, sizeof(entry.offset));
+	entry.reserved = 0;
+	memcpy(entry.residual, result.residual, sizeof(entry.residual));
+	if (!logReady || sessionLog.Append(RECORD_CALIBRATION, &entry, sizeof(entry)) != 0) {
+		serial.printf("Could not store the calibration\r\n");
+	}
 }
 
 
 /*************************************************
-Function: isSU
-Description: make judgement whether the exercise is SitUps based on presample data
+Function: captureTrace
+Description: streams raw samples to the serial port until a key or the user button is pressed
 Calls: None
-Called By: routinedExercise(), freeToExercise()
-Others: returns a bool value indicating whether SitUps or not
+Called By: serialCommands()
+Others: 
+
+the stream is CODEC_STREAM_MAGIC, the sample period, then SampleCodec blocks
+of CAPTURE_BLOCK samples and an empty block at the end,
+"codec decode" on the host turns it into a trace file
 *************************************************/
-bool isSU() {
-	double sumX = 0;
-	double sumY = 0;
-	double sumZ = 0;
-
-	/* calculating the average angle value for each axis */
-    for (int i = 0; i < PRESAMPLE_LENGTH; i++) {
-		sumX += presamplesBuffer[i][0];
-		sumY += presamplesBuffer[i][1];
-		sumZ += presamplesBuffer[i][2];
+void captureTrace() {
+	SampleEncoder encoder(PREDICT_DELTA);
+	uint32_t period = scheduler.PeriodUs();
+	uint64_t timestamp;
+	int16_t xyz[3];
+
+	/* Stream::write() is protected, send() of USBCDC blocks until the bytes are out */
+	serial.send((uint8_t *)CODEC_STREAM_MAGIC, 4);
+	serial.send((uint8_t *)&period, sizeof(period));
+	encoder.Begin(captureBuffer, sizeof(captureBuffer));
+	scheduler.Start();
+	while (!serial.readable() && MyButton != ON) {
+		scheduler.WaitNext(&timestamp);
+		acc.ReadChecked(&xyz[0], &xyz[1], &xyz[2]);
+		encoder.Push(xyz);
+		if (encoder.Samples() == CAPTURE_BLOCK) {
+			serial.send(captureBuffer, encoder.Finish());
+			encoder.Begin(captureBuffer, sizeof(captureBuffer));
+		}
 	}
-
-	if (sumZ/PRESAMPLE_LENGTH <= 180 && sumZ/PRESAMPLE_LENGTH >= 120 
-		&& sumY/PRESAMPLE_LENGTH <= 140 && sumY/PRESAMPLE_LENGTH >= 80
-		&& sumX/PRESAMPLE_LENGTH <= 100 && sumX/PRESAMPLE_LENGTH >= 60  ) {
-		MyLED3 = ON;
-		serial.printf("SitUps\n");
-		return true;
+	if (encoder.Samples() > 0) {
+		serial.send(captureBuffer, encoder.Finish());
+		encoder.Begin(captureBuffer, sizeof(captureBuffer));
 	}
-
-	return false;
+	serial.send(captureBuffer, encoder.Finish());	// empty block ends the stream
 }
 
 
 /*************************************************
-Function: countSU
-Description: if isSU returns true, start counting using this function
+Function: summarizeBurst
+Description: computes the peak magnitude and jerk of a burst snapshot
 Calls: None
-Called By: routinedExercise(), freeToExercise()
-Others: can be interrupted by user button to display process, count up to 5 reputations and stop
+Called By: captureBurst()
+Others: reads the samples in place, the snapshot is released by the caller,
+no serial or flash access so it can run between two FIFO reads
 *************************************************/
-void countSU(int initVal) {
-    int countSU = initVal;
-
-	while (countSU < 5) {
-		/* when button not triggered and 5 reputations not finished, continue detecting */
-		while (MyButton != ON && countSU < 5) {
-			sampleTwoSeconds();
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when maximum deteted, regards as one reputation finished */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					countSU++;
-				}
+void summarizeBurst(const BurstSnapshot &shot, uint32_t periodUs, BurstEntry &entry) {
+	int16_t countsPerG = acc.CountsPerG();
+	uint32_t peak2 = 0;
+	int peakJerk = 0;
+
+	for (uint16_t i = 0; i < shot.samples; i++) {
+		const int16_t *s = shot.Sample(i);
+		uint32_t m2 = (uint32_t)(s[0] * s[0]) + (uint32_t)(s[1] * s[1]) + (uint32_t)(s[2] * s[2]);
+		peak2 = m2 > peak2 ? m2 : peak2;
+		if (i > 0) {
+			const int16_t *p = shot.Sample(i - 1);
+			for (int a = 0; a < 3; a++) {
+				peakJerk = abs(s[a] - p[a]) > peakJerk ? abs(s[a] - p[a]) : peakJerk;
 			}
 		}
-
-		/* when button pressed, display the process and continue counting */
-		for (int i = 0; i < countSU; i++) {
-			MyLED3 = ON;
-			thread_sleep_for(SHORT_TIME);
-			MyLED3 = OFF;
-			thread_sleep_for(SHORT_TIME);
-		}
 	}
 
+	entry.uptimeMs = shot.triggerUs / 1000;
+	entry.samples = shot.samples;
+	entry.trigger = shot.trigger;
+	entry.periodUs = (uint16_t)periodUs;
+	entry.peakMg = (uint16_t)(sqrtf((float)peak2) * 1000 / countsPerG);
+	entry.peakJerk = (uint16_t)(peakJerk * 1000 / countsPerG);
+	entry.mode = TRIGGER_MAGNITUDE;
+	entry.reserved = 0;
 }
 
 
 /*************************************************
-Function: isJJ
-Description: make judgement whether the exercise is JumpJacks based on presample data
+Function: logBursts
+Description: prints the queued burst summaries and appends them to the session log
 Calls: None
-Called By: routinedExercise(), freeToExercise()
-Others: returns a bool value indicating whether JumpJacks or not
+Called By: captureBurst()
+Others: runs after the FIFO is off, an append may rotate the log and erase a sector
 *************************************************/
-bool isJJ() {
-	double sumX = 0;
-	double sumY = 0;
-	double sumZ = 0;
-
-	/* calculating the average angle value for each axis */
-    for (int i = 0; i < PRESAMPLE_LENGTH; i++) {
-		sumX += presamplesBuffer[i][0];
-		sumY += presamplesBuffer[i][1];
-		sumZ += presamplesBuffer[i][2];
-	}
-	if (sumZ/PRESAMPLE_LENGTH <= 80 && sumZ/PRESAMPLE_LENGTH >= 30 
-		&& sumY/PRESAMPLE_LENGTH <= 120 && sumY/PRESAMPLE_LENGTH >= 80
-		&& sumX/PRESAMPLE_LENGTH <= 160 && sumX/PRESAMPLE_LENGTH >= 60  ) {
-		MyLED6 = ON;
-		serial.printf("JumpJacks\n");
-		return true;
+void logBursts(int count) {
+	for (int i = 0; i < count; i++) {
+		const BurstEntry &entry = burstQueue[i];
+		serial.printf("burst #%lu at %lu ms: %u samples, peak %u mg, jerk %u mg/sample\r\n",
+			(unsigned long)burstQueueSequence[i], (unsigned long)entry.uptimeMs, entry.samples,
+			entry.peakMg, entry.peakJerk);
+		if (!logReady || sessionLog.Append(RECORD_BURST, &entry, sizeof(entry)) != 0) {
+			serial.printf("Could not log burst\r\n");
+		}
 	}
-	return false;
 }
 
 
 /*************************************************
-Function: countJJ
-Description: if isJJ returns true, start counting using this function
-Calls: None
-Called By: routinedExercise(), freeToExercise()
-Others: can be interrupted by user button to display process, count up to 5 reputations and stop
-*************************************************/
-void countJJ(int initVal) {
-    int countJJ = initVal;
+Function: captureBurst
+Description: samples at 1.6 kHz and keeps the movement around every strong acceleration
+Calls: summarizeBurst(), logBursts()
+Called By: serialCommands()
+Others: 
 
-	while (countJJ < 5) {
-		while (MyButton != ON && countJJ < 5) {
-			sampleTwoSeconds();
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when button not triggered and 5 reputations not finished, continue detecting */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					countJJ++;
-				}
+runs until a key or the user button is pressed,
+the sensor FIFO is read every BURST_POLL_MS into burst, which keeps BURST_PRE_MS
+of history and freezes BURST_PRE_MS + BURST_POST_MS around a magnitude above
+BURST_TRIGGER_MG, snapshots are read where they were acquired and released,
+acquisition goes on in the other blocks meanwhile,
+the summaries are queued and only printed and logged once the FIFO is off,
+so neither USB nor a flash erase delays a FIFO read,
+the 12.5 Hz / 2g configuration is restored at the end
+*************************************************/
+void captureBurst() {
+	const LIS3DSH::DataRate odr = LIS3DSH::ODR_1600HZ;
+	uint32_t period = LIS3DSH::PeriodUs(odr);
+	uint32_t overruns = 0;
+	uint32_t unlogged = 0;
+	int queued = 0;
+	bool overrun;
+
+	acc.SetFullScale(LIS3DSH::FS_8G);		// a landing exceeds 2g
+	acc.SetDataRate(odr);
+	acc.SetFifo(true);
+
+	BurstConfig config;
+	config.trigger = TRIGGER_MAGNITUDE;
+	config.threshold = (int32_t)BURST_TRIGGER_MG * acc.CountsPerG() / 1000;
+	config.preSamples = (uint16_t)(BURST_PRE_MS * 1000 / period);
+	config.postSamples = (uint16_t)(BURST_POST_MS * 1000 / period);
+	config.periodUs = period;
+	burst.Start(config);
+
+	serial.printf("Burst capture, %u + %u samples at %lu us\r\n",
+		burst.Config().preSamples, burst.Config().postSamples, (unsigned long)period);
+	while (!serial.readable() && MyButton != ON) {
+		int n = acc.ReadFifo(fifoSamples, LIS3DSH::FIFO_DEPTH, &overrun);
+		overruns += overrun;
+		burst.Push(fifoSamples, n, us_ticker_read());
+
+		const BurstSnapshot *shot = burst.Ready();
+		if (shot != NULL) {
+			if (queued < BURST_QUEUE) {
+				burstQueueSequence[queued] = shot->sequence;
+				summarizeBurst(*shot, period, burstQueue[queued++]);
+			} else {
+				unlogged++;
 			}
+			burst.Release(shot);
 		}
+		thread_sleep_for(BURST_POLL_MS);
+	}
 
-		/* when button pressed, display the process and continue counting */
-		for (int i = 0; i < countJJ; i++) {
-			MyLED6 = ON;
-			thread_sleep_for(SHORT_TIME);
-			MyLED6 = OFF;
-			thread_sleep_for(SHORT_TIME);
+	acc.SetFifo(false);
+	acc.SetDataRate(LIS3DSH::ODR_12_5HZ);
+	acc.SetFullScale(LIS3DSH::FS_2G);
+	logBursts(queued);
+	serial.printf("%lu bursts, %lu dropped, %lu not logged, %lu FIFO overruns\r\n",
+		(unsigned long)burst.Triggers(), (unsigned long)burst.Dropped(), (unsigned long)unlogged,
+		(unsigned long)overruns);
+}
+
+
+/*************************************************
+Function: serialCommands
+Description: handles single character commands from the serial terminal
+Calls: serialPrint(), captureTrace(), calibrate(), captureBurst()
+Called By: sampleTwoSeconds(), waitStill(), waitingLight()
+Others: 
+
+p - dump the hot path profile (PROFILER_ENABLED builds)
+r - reset the hot path profile
+j - print the sampling jitter statistics
+l - list the latest logged sessions
+c - stream a compressed raw capture, see captureTrace()
+k - calibrate the accelerometer offsets
+b - print the boot and mode start times
+h - print the accelerometer fault counters
+x - triggered burst capture at 1.6 kHz, see captureBurst()
+
+c, k and x take over the sensor or change its offsets, they are only
+accepted when idle (waitingLight()), never in the middle of a window
+*************************************************/
+void serialCommands(bool idle) {
+	while (serial.readable()) {
+		int command = serial.getc();
+		switch (command) {
+		case 'j': {
+			const JitterStats &stats = scheduler.Stats();
+			if (stats.samples > 0) {
+				serial.printf("period %lu us, samples %lu, missed %lu\r\n",
+					(unsigned long)scheduler.PeriodUs(), (unsigned long)stats.samples, (unsigned long)stats.missed);
+				serial.printf("late min %lu mean %lu max %lu us, interval min %lu max %lu us\r\n",
+					(unsigned long)stats.minLateUs, (unsigned long)(stats.sumLateUs / stats.samples),
+					(unsigned long)stats.maxLateUs, (unsigned long)stats.minIntervalUs, (unsigned long)stats.maxIntervalUs);
+			}
+			break;
+		}
+#ifdef PROFILER_ENABLED
+		case 'p':
+			profilerDump(serialPrint);
+			break;
+		case 'r':
+			profilerReset();
+			break;
+#endif
+		case 'l':
+			printSessions(20);
+			break;
+		case 'c':
+		case 'k':
+		case 'x':
+			if (!idle) {
+				serial.printf("Busy, send it again while waiting for the button\r\n");
+			} else if (command == 'c') {
+				captureTrace();
+			} else if (command == 'k') {
+				calibrate();
+			} else {
+				captureBurst();
+			}
+			break;
+		case 'h': {
+			const LIS3DSHHealth &health = acc.Health();
+			serial.printf("samples %lu, stale %lu, stalls %lu, frozen %lu, identity %lu, bus %lu\r\n",
+				(unsigned long)health.samples, (unsigned long)health.staleReads, (unsigned long)health.stalls,
+				(unsigned long)health.frozen, (unsigned long)health.identityErrors, (unsigned long)health.busErrors);
+			serial.printf("recoveries %lu, failed %lu, last %lu us, max %lu us\r\n",
+				(unsigned long)health.recoveries, (unsigned long)health.failedRecoveries,
+				(unsigned long)health.lastRecoveryUs, (unsigned long)health.maxRecoveryUs);
+			break;
+		}
+		case 'b':
+			serial.printf("first sample %lu us after reset (main %lu us, %d failed starts), first classification %lu ms after the button, settled in %lu ms\r\n",
+				(unsigned long)firstSampleUs, (unsigned long)mainUs, bootFailures,
+				(unsigned long)(firstClassificationUs / 1000), (unsigned long)settleMs);
+			break;
+		default:
+			break;
 		}
 	}
-
 }
 
 
 /*************************************************
-Function: isPU
-Description: make judgement whether the exercise is PushUps based on presample data
+Function: sampling
+Description: Code modified from TA Michael's demo, used to sample one data on each axis
 Calls: None
+Called By: sampleTwoSeconds()
+Others: appends the filtered sample, stamped with timestampUs, to presamples
+through the acquisition pipeline
+*************************************************/
+void sampling(uint32_t timestampUs) {
+	PROFILE_SCOPE(PROBE_SAMPLING);
+
+	/* read data from the accelerometer (a locked up sensor is restarted by the driver),
+	   moving average, append to presamples, angles are computed from the window when needed */
+	acquisition.Push(timestampUs);
+}
+
+
+/*************************************************
+Function: sampleTwoSeconds
+Description: sampling for two seconds
+Calls: sampling()
 Called By: routinedExercise(), freeToExercise()
-Others: returns a bool value indicating whether PushUps or not
+Others: 
+
+store the sampled data in presamples,
+samples are taken on a fixed 0.1s deadline grid, so the window always spans two seconds,
+a deadline that passed while busy is skipped, leaving the window short by one sample,
+returns the number of skipped deadlines
 *************************************************/
-bool isPU() {
-	double sumX = 0;
-	double sumY = 0;
-	double sumZ = 0;
-
-	/* calculating the average angle value for each axis */
-    for (int i = 0; i < PRESAMPLE_LENGTH; i++) {
-		sumX += presamplesBuffer[i][0];
-		sumY += presamplesBuffer[i][1];
-		sumZ += presamplesBuffer[i][2];
-	}
-	if (sumZ/PRESAMPLE_LENGTH <= 40 && sumZ/PRESAMPLE_LENGTH >= 20 
-		&& sumY/PRESAMPLE_LENGTH <= 90 && sumY/PRESAMPLE_LENGTH >= 60
-		&& sumX/PRESAMPLE_LENGTH <= 100 && sumX/PRESAMPLE_LENGTH >= 80  ) {
-		MyLED5 = ON;
-		serial.printf("PushUps\n");
-		return true;
+int sampleTwoSeconds() {
+	int missed = 0;
+
+	presamples.Clear();
+	scheduler.Start();
+    /* one sampel per 0.1s, so for two seconds, we need 20 slots, which is SampleWindow::LENGTH */
+    for (int slot = 0; slot < SampleWindow::LENGTH; slot++) {
+		uint64_t timestamp;
+		int skipped = scheduler.WaitNext(&timestamp);
+		if (slot + skipped >= SampleWindow::LENGTH) {
+			missed += SampleWindow::LENGTH - slot;
+			break;
+		}
+		missed += skipped;
+		slot += skipped;
+		sampling((uint32_t)timestamp);
+		serialCommands(false);
+    }
+
+	if (missed > 0) {
+		serial.printf("Missed %d sampling deadlines\r\n", missed);
 	}
-	return false;
+	return missed;
 }
 
 
 /*************************************************
-Function: countPU
-Description: if isPU returns true, start counting using this function
-Calls: None
+Function: countReps
+Description: once the exercise is recognized, start counting using this function
+Calls: sampleTwoSeconds()
 Called By: routinedExercise(), freeToExercise()
-Others: can be interrupted by user button to display process, count up to 5 reputations and stop
+Others: can be interrupted by user button to display process, count up to
+exercise.targetReps reputations and stop, returns the number of reputations counted,
+the same loop serves every row of EXERCISES
 *************************************************/
-void countPU(int initVal) {
-    int countPU = initVal;
+int countReps(const ExerciseDescriptor &exercise, int initVal) {
+	DigitalOut &led = *LEDS[exercise.led];
+	int count = initVal;
 
-	while (countPU < 5) {
-		while (MyButton != ON && countPU < 5) {
+	while (count < exercise.targetReps) {
+		/* when button not triggered and the set not finished, continue detecting */
+		while (MyButton != ON && count < exercise.targetReps) {
 			sampleTwoSeconds();
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when button not triggered and 5 reputations not finished, continue detecting */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					countPU++;
-				}
-			}
+			/* when maximum deteted, regards as one reputation finished */
+			count += presamples.CountPeaks(exercise.axis);
 		}
 
 		/* when button pressed, display the process and continue counting */
-		for (int i = 0; i < countPU; i++) {
-			MyLED5 = ON;
+		for (int i = 0; i < count; i++) {
+			led = ON;
 			thread_sleep_for(SHORT_TIME);
-			MyLED5 = OFF;
+			led = OFF;
 			thread_sleep_for(SHORT_TIME);
 		}
 	}
+	return count;
 }
 
 
 /*************************************************
-Function: isS
-Description: make judgement whether the exercise is Squart based on presample data
-Calls: None
-Called By: routinedExercise(), freeToExercise()
-Others: returns a bool value indicating whether Squart or not
+Function: waitStill
+Description: waits until the board is still, replaces a fixed settle time
+Calls: serialCommands()
+Called By: main()
+Others: 
+
+returns once STILL_SAMPLES raw samples in a row stay within STILL_RANGE on every axis,
+e.g. after the vibration of the button press, at the latest after LONG_TIME,
+returns the time waited in ms
 *************************************************/
-bool isS() {
-	double sumX = 0;
-	double sumY = 0;
-	double sumZ = 0;
-
-	/* calculating the average angle value for each axis */
-    for (int i = 0; i < PRESAMPLE_LENGTH; i++) {
-		sumX += presamplesBuffer[i][0];
-		sumY += presamplesBuffer[i][1];
-		sumZ += presamplesBuffer[i][2];
-	}
-	if (sumZ/PRESAMPLE_LENGTH <= 180 && sumZ/PRESAMPLE_LENGTH >= 120 
-		&& sumY/PRESAMPLE_LENGTH <= 140 && sumY/PRESAMPLE_LENGTH >= 80
-		&& sumX/PRESAMPLE_LENGTH <= 100 && sumX/PRESAMPLE_LENGTH >= 60  ) {
-		MyLED4 = ON;
-		serial.printf("Squarts\n");
-		return true;
+uint32_t waitStill() {
+	uint64_t start = SampleScheduler::Now();
+	uint64_t timestamp;
+	int16_t xyz[3];
+
+	stillness.Reset();
+	scheduler.Start();
+	while (SampleScheduler::Now() - start < (uint64_t)LONG_TIME * 1000) {
+		scheduler.WaitNext(&timestamp);
+		acc.ReadChecked(&xyz[0], &xyz[1], &xyz[2]);	// a lock-up is caught here as well
+		if (stillness.Push(xyz[0], xyz[1], xyz[2])) {
+			break;
+		}
+		serialCommands(false);
 	}
-	return false;
+	settleMs = (uint32_t)((SampleScheduler::Now() - start) / 1000);
+	return settleMs;
 }
 
 
 /*************************************************
-Function: countS
-Description: if isS returns true, start counting using this function
+Function: blinkAll
+Description: blinks the four LEDs together once
 Calls: None
 Called By: routinedExercise(), freeToExercise()
-Others: can be interrupted by user button to display process, count up to 5 reputations and stop
+Others: shows that a set or the routine is finished
 *************************************************/
-void countS(int initVal) {
-    int countS = initVal;
-
-	while (countS < 5) {
-		while (MyButton != ON && countS < 5) {
-			sampleTwoSeconds();
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when button not triggered and 5 reputations not finished, continue detecting */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					countS++;
-				}
-			}
-		}
-
-		/* when button pressed, display the process and continue counting */
-		for (int i = 0; i < countS; i++) {
-			MyLED4 = ON;
-			thread_sleep_for(SHORT_TIME);
-			MyLED4 = OFF;
-			thread_sleep_for(SHORT_TIME);
-		}
+void blinkAll() {
+	for (int i = 0; i < 4; i++) {
+		*LEDS[i] = ON;
+	}
+	thread_sleep_for(SHORT_TIME);
+	for (int i = 0; i < 4; i++) {
+		*LEDS[i] = OFF;
 	}
+	thread_sleep_for(SHORT_TIME);
 }
 
 
 /*************************************************
 Function: waitingLight
 Description: indicating waiting state
-Calls: None
+Calls: serialCommands()
 Called By: main(), freeToExercise()
 Others: 
 
@@ -437,6 +614,7 @@ void waitingLight() {
 		thread_sleep_for(SHORT_TIME);
 		MyLED4 = OFF;
 		serial.printf("Waiting\r\n");
+		serialCommands(true);
 	}
 	return;
 }
@@ -445,20 +623,22 @@ void waitingLight() {
 /*************************************************
 Function: freeToExercise
 Description: free exercise model
-Calls: None
+Calls: countReps(), blinkAll()
 Called By: main()
 Others: 
 
 This is the model when user can do any exercise as wished,
 when entered, four LEDs will be blinking in circle quickly,
-type of exercise will be detected automatically,
+type of exercise will be detected automatically by the classifier,
+a window whose best class is below the minConfidence of its row in EXERCISES is deferred,
+unless the same class has won DEFER_LIMIT windows in a row,
 
 led3 indicates Situps,
 led5 indicates Pushups,
 led6 indicates Jumping Jacks,
 led4 indicate Squats,
 
-for each kind of exercise, the program will count for 5 times,
+for each kind of exercise, the program will count up to its targetReps (5),
 each LED will blink corresponding times to indicate how many repetitions has been counted,
 after finished, all the four lights will be blinking.
 
@@ -482,6 +662,10 @@ void freeToExercise() {
 		MyLED4 = OFF;
 	}
 
+	uint8_t lastBest = MODEL_REST;			// class that won the previous window
+	int agreeing = 0;						// consecutive windows won by lastBest
+	bool classified = false;				// firstClassificationUs taken
+
 	while(!isButtonPressed) {
 		/* get the state of user button */
 		isButtonPressed = MyButton;
@@ -494,109 +678,43 @@ void freeToExercise() {
 		/* presampling 2 secs for exercise detection */
 		sampleTwoSeconds();
 
-		if (isSU()) {
-			int initVal = 0;
-			/* check data presampled in the previous 2secs */
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when maximum deteted, regards as one reputation finished */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					initVal++;
-				}
-			}
-			countSU(initVal);
-			for(int i = 0; i < 3; i++) {
-				MyLED3 = ON;
-				MyLED5 = ON;
-				MyLED6 = ON;
-				MyLED4 = ON;
-				thread_sleep_for(SHORT_TIME);
-				MyLED3 = OFF;
-				MyLED5 = OFF;
-				MyLED6 = OFF;
-				MyLED4 = OFF;
-				thread_sleep_for(SHORT_TIME);
-			}
-			return;
+		int8_t features[MODEL_FEATURE_COUNT];
+		ClassifierResult result;
+		{
+			PROFILE_SCOPE(PROBE_CLASSIFY);
+			extractFeatures(presamples, features);
+			classify(features, &result);
 		}
-
-		if (isPU()) {
-			int initVal = 0;
-			/* check data presampled in the previous 2secs */
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when maximum deteted, regards as one reputation finished */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					initVal++;
-				}
-			}
-			countPU(initVal);
-			for(int i = 0; i < 3; i++) {
-				MyLED3 = ON;
-				MyLED5 = ON;
-				MyLED6 = ON;
-				MyLED4 = ON;
-				thread_sleep_for(SHORT_TIME);
-				MyLED3 = OFF;
-				MyLED5 = OFF;
-				MyLED6 = OFF;
-				MyLED4 = OFF;
-				thread_sleep_for(SHORT_TIME);
-			}
-			return;
+		if (!classified) {
+			firstClassificationUs = (uint32_t)(SampleScheduler::Now() - modeStartUs);
+			classified = true;
 		}
 
-		if (isJJ()) {
-			int initVal = 0;
-			/* check data presampled in the previous 2secs */
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when maximum deteted, regards as one reputation finished */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					initVal++;
-				}
-			}
-			countJJ(initVal);
-			for(int i = 0; i < 3; i++) {
-				MyLED3 = ON;
-				MyLED5 = ON;
-				MyLED6 = ON;
-				MyLED4 = ON;
-				thread_sleep_for(SHORT_TIME);
-				MyLED3 = OFF;
-				MyLED5 = OFF;
-				MyLED6 = OFF;
-				MyLED4 = OFF;
-				thread_sleep_for(SHORT_TIME);
-			}
-			return;
+		agreeing = (result.best == lastBest) ? agreeing + 1 : 1;
+		lastBest = result.best;
+
+		const ExerciseDescriptor *exercise = findExercise(result.best);
+		if (exercise == NULL) {
+			continue;
 		}
+		/* not confident yet, defer unless the same class keeps winning */
+		if (result.confidence[result.best] < exercise->minConfidence && agreeing < DEFER_LIMIT) {
+			serial.printf("Deferred %s (%d/255)\n", MODEL_CLASS_NAMES[result.best], result.confidence[result.best]);
+			continue;
+		}
+		serial.printf("%s (%d/255)\n", MODEL_CLASS_NAMES[result.best], result.confidence[result.best]);
 
-		if (isS()) {
-			int initVal = 0;
-			/* check data presampled in the previous 2secs */
-			for (int i = 1; i < PRESAMPLE_LENGTH-1; i++) {
-				/* when maximum deteted, regards as one reputation finished */
-				if (presamplesBuffer[i][1] > presamplesBuffer[i-1][1] 
-					&& presamplesBuffer[i][1] > presamplesBuffer[i+1][1]) {
-					initVal++;
-				}
-			}
-			countS(initVal);
-			for(int i = 0; i < 3; i++) {
-				MyLED3 = ON;
-				MyLED5 = ON;
-				MyLED6 = ON;
-				MyLED4 = ON;
-				thread_sleep_for(SHORT_TIME);
-				MyLED3 = OFF;
-				MyLED5 = OFF;
-				MyLED6 = OFF;
-				MyLED4 = OFF;
-				thread_sleep_for(SHORT_TIME);
-			}
-			return;
+		/* check data presampled in the previous 2secs, each maximum is one reputation */
+		int initVal = presamples.CountPeaks(exercise->axis);
+
+		uint64_t start = SampleScheduler::Now();
+		*LEDS[exercise->led] = ON;
+		logSession(SESSION_FREE, exercise->exercise, countReps(*exercise, initVal), start);
+
+		for(int i = 0; i < 3; i++) {
+			blinkAll();
 		}
+		return;
 	}
 	return;
 }
@@ -605,13 +723,13 @@ void freeToExercise() {
 /*************************************************
 Function: routinedExercise
 Description: routined exercise model
-Calls: None
+Calls: countReps(), blinkAll()
 Called By: main()
 Others: 
 
 This is the mode used when user wish to do routined exercise,
 when entered, the four LEDs will be blinking in reverse order quickly,
-type of exercise has been arranged as follows:
+type of exercise has been arranged as follows (order of EXERCISES):
 
 1. 1st gourp: 5 Situps
 2. 2nd group: 5 Pushups
@@ -641,112 +759,71 @@ void routinedExercise() {
 
 	serial.printf("Rountined Model\r\n");
 
-	bool sitUpsFinished = false;
-	bool pushUpsFinished = false;
-	bool jumpJacksFinished = false;
-	bool squartsFinished = false;
-
-	while(true) {
-		/* get the state of user button */
-		isButtonPressed = MyButton;
+	/* one group per row of EXERCISES, each started by the user button */
+	for (int i = 0; i < EXERCISE_COUNT; i++) {
+		const ExerciseDescriptor &exercise = EXERCISES[i];
 
-		/* detection for Situps */
-		if (isButtonPressed 
-			&& !sitUpsFinished 
-			&& !pushUpsFinished 
-			&& !jumpJacksFinished 
-			&& !squartsFinished) {
-			/* LED3 turns on, reminding user to do Situps. */
-			MyLED3 = ON;
-			/* different with free mode, no presampling process, initVal is 0 */
-			countSU(0);
-			sitUpsFinished = true;
+		while (MyButton != ON) {
 		}
-		/* get the state of user button */
-		isButtonPressed = MyButton;
+		/* LED of the exercise turns on, reminding user which one to do */
+		*LEDS[exercise.led] = ON;
+		/* different with free mode, no presampling process, initVal is 0 */
+		uint64_t start = SampleScheduler::Now();
+		logSession(SESSION_ROUTINE, exercise.exercise, countReps(exercise, 0), start);
+	}
+
+	/* when all finished, blink all leds and wait for user button interrupt to return */
+	while (MyButton != ON) {
+		blinkAll();
+	}
+}
 
-		/* detection for Pushups */
-		if (isButtonPressed 
-			&& sitUpsFinished 
-			&& !pushUpsFinished
-			&& !jumpJacksFinished 
-			&& !squartsFinished) {
-			/* LED5 turns on, reminding user to do Pushups. */
-			MyLED5 = ON;
-			/* different with free mode, no presampling process, initVal is 0 */
-			countPU(0);
-			pushUpsFinished = true;
-		}
-		/* get the state of user button */
-		isButtonPressed = MyButton;
-		
-		/* detection for Jumping Jacks */
-		if (isButtonPressed 
-			&& sitUpsFinished 
-			&& pushUpsFinished 
-			&& !jumpJacksFinished 
-			&& !squartsFinished) {
-			/* LED6 turns on, reminding user to do JumpingJacks. */
-			MyLED6 = ON;
-			/* different with free mode, no presampling process, initVal is 0 */
-			countJJ(0);
-			jumpJacksFinished = true;
-		}
-		/* get the state of user button */
-		isButtonPressed = MyButton;
 
-		/* detection for Squats */
-		if (isButtonPressed 
-			&& sitUpsFinished 
-			&& pushUpsFinished 
-			&& jumpJacksFinished 
-			&& !squartsFinished) {
-			/* LED4 turns on, reminding user to do Squarts. */
+int main() {
+	/* the raw us ticker counts since HAL_Init() in mbed's startup, the 64 bit
+	   ticker of SampleScheduler::Now() only from its first use */
+	mainUs = us_ticker_read();
+	PROFILE_INIT();
+
+	/* reset the accelerometer and wait for its first sample, each attempt is bounded,
+	   the red LED blinks once BOOT_ATTEMPTS attempts failed */
+	while (acc.Begin(BOOT_TIMEOUT_US) != 0) {
+		bootFailures++;
+		printf("Could not detect Accelerometer, attempt %d\n\r", bootFailures);
+		if (bootFailures < BOOT_ATTEMPTS) {
 			MyLED4 = ON;
-			/* different with free mode, no presampling process, initVal is 0 */
-			countS(0);
-			squartsFinished = true;
-			/* when all finished, blink all leds and wait for user button interrupt to return */
-			while (MyButton != ON) {
-				MyLED3 = ON;
-				MyLED5 = ON;
-				MyLED6 = ON;
-				MyLED4 = ON;
-				thread_sleep_for(SHORT_TIME);
-				MyLED3 = OFF;
-				MyLED5 = OFF;
-				MyLED6 = OFF;
-				MyLED4 = OFF;
-				thread_sleep_for(SHORT_TIME);
-			}
-			return;
+		} else {
+			MyLED4 = OFF;
+			MyLED5 = !MyLED5;
+			thread_sleep_for(VERY_SHORT_TIME);
 		}
-
-		
 	}
-}
+	firstSampleUs = us_ticker_read();
+	MyLED4 = OFF;
+	MyLED5 = OFF;
 
+	/* recover the session log, formats the sectors on first use,
+	   the latest calibration is carried over when its sector is rotated out */
+	sessionLog.Keep(RECORD_CALIBRATION);
+	logReady = (sessionLog.Mount() == 0);
 
-int main() {
-	/* check detection of the accelerometer */
-	while(acc.Detect() != 1) {
-        printf("Could not detect Accelerometer\n\r");
-		MyLED4 = 1;
-		wait_ms(200);
-    }
+	/* zero-g offsets from the last calibration */
+	loadCalibration();
 
 	while(1) {
 		/* Waiting for user button interrupt. */
 		waitingLight();
+		modeStartUs = SampleScheduler::Now();
 
-		/* Wait for 3 seconds, to detach any vibrations. */
-		wait_ms(LONG_TIME);
+		/* Wait until the vibrations of the button press are gone. */
+		waitStill();
 
 		/* Free to choose any exercise. */
 		freeToExercise();
 		isButtonPressed = false;
 
-		wait_ms(LONG_TIME);
+		modeStartUs = SampleScheduler::Now();
+		waitStill();
 
 		/* Rountined exercise */
 		routinedExercise();
@@ -0,0 +1,480 @@
+/*****************************************************************************
+File name: batch_eval.cpp
+Description: Replays the free exercise mode of the firmware (filter, window,
+             classifier, deferring and rep counting) over a corpus of traces
+             on all cores, with a confusion matrix, the rep count error and a
+             sweep of the acceptance parameters
+Author: Junyu Bian
+Date: 10/18/2026
+
+Usage:
+    batch_eval <dir or trace.csv>... [--threads N]
+               [--confidence 160 | 100:240:20] [--defer 3 | 1:5:1]
+
+Every *.csv below the given directories is one set: the label comes from the
+"# label:" header (else the directory), the expected repetitions from
+"# reps:". Samples are taken on the 0.1s grid of the firmware. Without
+--confidence every exercise keeps the minConfidence of its row in
+include/Exercise.h. Repetitions are counted from the accepted window to the
+end of the trace, not capped at targetReps.
+*****************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Classifier.h"
+#include "Exercise.h"
+#include "LIS3DSH.h"
+#include "MovingAverage.h"
+#include "SampleWindow.h"
+#include "TraceFile.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const int16_t COUNTS_PER_G = LIS3DSH::CountsPerG(LIS3DSH::FS_2G);
+static const uint32_t SAMPLE_PERIOD_US = 100000;    // SAMPLE_PERIOD_US of main.cpp
+static const int DEFER_LIMIT = 3;                   // DEFER_LIMIT of main.cpp
+
+/********** work stealing pool ********************/
+
+/* Every worker owns a deque of task indices, takes its own tasks from the
+   back and steals from the front of the others once it runs dry. Tasks do
+   not create tasks, so a full round of empty deques means the run is over. */
+class WorkStealingPool {
+  public:
+    typedef std::function<void(unsigned worker, size_t task)> Task;
+
+    explicit WorkStealingPool(unsigned threads) : _queues(threads ? threads : 1), _steals(0) {}
+
+    unsigned Threads(void) const { return (unsigned)_queues.size(); }
+    uint64_t Steals(void) const { return _steals; }
+
+    /* runs fn for tasks 0 .. count - 1, each worker starts with a contiguous block */
+    void Run(size_t count, const Task &fn) {
+        unsigned threads = Threads();
+        for (unsigned w = 0; w < threads; w++) {
+            size_t begin = count * w / threads, end = count * (w + 1) / threads;
+            for (size_t t = begin; t < end; t++) {
+                _queues[w].tasks.push_back(t);
+            }
+        }
+        std::vector<std::thread> workers;
+        for (unsigned w = 1; w < threads; w++) {
+            workers.push_back(std::thread(&WorkStealingPool::Work, this, w, std::cref(fn)));
+        }
+        Work(0, fn);
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+    }
+
+  private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    bool Pop(unsigned w, size_t *task) {
+        std::lock_guard<std::mutex> guard(_queues[w].lock);
+        if (_queues[w].tasks.empty()) {
+            return false;
+        }
+        *task = _queues[w].tasks.back();
+        _queues[w].tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(unsigned w, size_t *task) {
+        for (unsigned i = 1; i < Threads(); i++) {
+            Queue &victim = _queues[(w + i) % Threads()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                *task = victim.tasks.front();
+                victim.tasks.pop_front();
+                _steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Work(unsigned w, const Task &fn) {
+        size_t task;
+        while (Pop(w, &task) || Steal(w, &task)) {
+            fn(w, task);
+        }
+    }
+
+    std::vector<Queue> _queues;
+    std::atomic<uint64_t> _steals;
+};
+
+/********** evaluation ********************/
+
+/* acceptance parameters of freeToExercise(), confidence < 0 keeps the table */
+struct Params {
+    int confidence;
+    int deferLimit;
+};
+
+struct Stats {
+    uint64_t confusion[MODEL_CLASS_COUNT][MODEL_CLASS_COUNT];   // [expected][predicted]
+    uint64_t repSets;           // sets with a "# reps:" header and a recognized exercise
+    uint64_t exactReps;
+    int64_t sumRepError;        // counted - expected
+    uint64_t sumAbsRepError;
+
+    void Add(const Stats &o) {
+        for (int i = 0; i < MODEL_CLASS_COUNT; i++)
+            for (int j = 0; j < MODEL_CLASS_COUNT; j++)
+                confusion[i][j] += o.confusion[i][j];
+        repSets += o.repSets;
+        exactReps += o.exactReps;
+        sumRepError += o.sumRepError;
+        sumAbsRepError += o.sumAbsRepError;
+    }
+
+    uint64_t Sets(void) const {
+        uint64_t n = 0;
+        for (int i = 0; i < MODEL_CLASS_COUNT; i++)
+            for (int j = 0; j < MODEL_CLASS_COUNT; j++)
+                n += confusion[i][j];
+        return n;
+    }
+
+    double Accuracy(void) const {
+        uint64_t hit = 0;
+        for (int i = 0; i < MODEL_CLASS_COUNT; i++)
+            hit += confusion[i][i];
+        return Sets() ? (double)hit / Sets() : 0;
+    }
+};
+
+/* what the firmware sees of one window, independent of the parameters */
+struct WindowResult {
+    uint8_t best;
+    uint8_t confidence;         // of best
+    uint8_t peaks[3];           // CountPeaks() per axis
+};
+
+/* per worker state, merged after the run */
+struct Worker {
+    Trace trace;
+    std::vector<WindowResult> windows;
+    std::vector<Stats> stats;   // one per Params
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t failed;
+};
+
+static int classOf(const std::string &label) {
+    for (int c = 0; c < MODEL_CLASS_COUNT; c++) {
+        std::string name = MODEL_CLASS_NAMES[c];
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (name == label) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+/* maps the whole file read only, the parser walks it once */
+static bool mapTrace(const std::string &path, Trace *trace, uint64_t *bytes) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    bool ok = false;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+            ok = parseTrace((const char *)data, (size_t)st.st_size, path, trace);
+            munmap(data, (size_t)st.st_size);
+            *bytes += (uint64_t)st.st_size;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+/* filters the samples on the sampling grid into consecutive windows, as sampleTwoSeconds() */
+static void replayWindows(const Trace &trace, std::vector<WindowResult> *windows) {
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    uint32_t next = trace.timestamps.empty() ? 0 : trace.timestamps[0];
+
+    windows->clear();
+    for (size_t i = 0; i < trace.Samples(); i++) {
+        if ((int32_t)(trace.timestamps[i] - next) < 0) {
+            continue;                   // faster capture, keep one sample per period
+        }
+        next += SAMPLE_PERIOD_US;
+        int16_t fx, fy, fz;
+        const int16_t *s = &trace.xyz[3 * i];
+        filter.Push(s[0], s[1], s[2], &fx, &fy, &fz);
+        window.Push(fx, fy, fz, trace.timestamps[i]);
+        if (!window.Full()) {
+            continue;
+        }
+
+        int8_t features[MODEL_FEATURE_COUNT];
+        ClassifierResult result;
+        WindowResult w;
+        extractFeatures(window, features);
+        classify(features, &result);
+        w.best = result.best;
+        w.confidence = result.confidence[result.best];
+        for (int a = 0; a < 3; a++) {
+            w.peaks[a] = (uint8_t)window.CountPeaks((Axis)a);
+        }
+        windows->push_back(w);
+        window.Clear();
+    }
+}
+
+/* the decision of freeToExercise() and the count of countReps() for one set */
+static void evaluate(const std::vector<WindowResult> &windows, int expected, int reps,
+                     const Params &params, Stats *stats) {
+    uint8_t lastBest = MODEL_REST;
+    int agreeing = 0;
+    int predicted = MODEL_REST;
+    int counted = 0;
+
+    for (size_t i = 0; i < windows.size(); i++) {
+        const WindowResult &w = windows[i];
+        agreeing = (w.best == lastBest) ? agreeing + 1 : 1;
+        lastBest = w.best;
+
+        const ExerciseDescriptor *exercise = findExercise(w.best);
+        if (exercise == NULL) {
+            continue;
+        }
+        int minConfidence = params.confidence < 0 ? exercise->minConfidence : params.confidence;
+        if (w.confidence < minConfidence && agreeing < params.deferLimit) {
+            continue;
+        }
+        predicted = w.best;
+        for (size_t j = i; j < windows.size(); j++) {
+            counted += windows[j].peaks[exercise->axis];
+        }
+        break;
+    }
+
+    stats->confusion[expected][predicted]++;
+    if (reps >= 0 && findExercise((uint8_t)expected) != NULL) {
+        int error = counted - reps;
+        stats->repSets++;
+        stats->exactReps += (error == 0);
+        stats->sumRepError += error;
+        stats->sumAbsRepError += (uint64_t)abs(error);
+    }
+}
+
+/********** command line ********************/
+
+static bool endsWith(const std::string &s, const char *suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static void findTraces(const std::string &path, std::vector<std::string> *files) {
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL) {
+        if (endsWith(path, ".csv")) {
+            files->push_back(path);
+        }
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::string child = path + "/" + entry->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            findTraces(child, files);
+        } else if (endsWith(child, ".csv")) {
+            files->push_back(child);
+        }
+    }
+    closedir(dir);
+}
+
+/* "v" or "first:last:step" */
+static bool parseRange(const char *text, std::vector<int> *values) {
+    int first, last, step = 1;
+    int n = sscanf(text, "%d:%d:%d", &first, &last, &step);
+    if (n == 1) {
+        last = first;
+    } else if (n < 2 || step <= 0 || last < first) {
+        return false;
+    }
+    values->clear();
+    for (int v = first; v <= last; v += step) {
+        values->push_back(v);
+    }
+    return true;
+}
+
+static void printConfusion(const Stats &s) {
+    printf("%-12s", "expected");
+    for (int p = 0; p < MODEL_CLASS_COUNT; p++) {
+        printf(" %10s", MODEL_CLASS_NAMES[p]);
+    }
+    printf("\n");
+    for (int e = 0; e < MODEL_CLASS_COUNT; e++) {
+        printf("%-12s", MODEL_CLASS_NAMES[e]);
+        for (int p = 0; p < MODEL_CLASS_COUNT; p++) {
+            printf(" %10llu", (unsigned long long)s.confusion[e][p]);
+        }
+        printf("\n");
+    }
+}
+
+static std::string confidenceName(const Params &p) {
+    return p.confidence < 0 ? std::string("table") : std::to_string(p.confidence);
+}
+
+static void usage(void) {
+    fprintf(stderr,
+        "usage: batch_eval <dir or trace.csv>... [--threads N]\n"
+        "                  [--confidence 160 | 100:240:20] [--defer 3 | 1:5:1]\n");
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> inputs;
+    std::vector<int> confidences(1, -1);
+    std::vector<int> defers(1, DEFER_LIMIT);
+    unsigned threads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--confidence") && i + 1 < argc) {
+            if (!parseRange(argv[++i], &confidences)) {
+                usage();
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "--defer") && i + 1 < argc) {
+            if (!parseRange(argv[++i], &defers)) {
+                usage();
+                return 2;
+            }
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        findTraces(inputs[i], &files);
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        fprintf(stderr, "no trace files found\n");
+        return 2;
+    }
+
+    std::vector<Params> params;
+    for (size_t c = 0; c < confidences.size(); c++) {
+        for (size_t d = 0; d < defers.size(); d++) {
+            Params p = {confidences[c], defers[d]};
+            params.push_back(p);
+        }
+    }
+
+    WorkStealingPool pool(threads ? threads : 1);
+    std::vector<Worker> workers(pool.Threads());
+    for (size_t w = 0; w < workers.size(); w++) {
+        workers[w].stats.assign(params.size(), Stats());
+        workers[w].samples = workers[w].bytes = workers[w].failed = 0;
+    }
+    std::atomic<uint64_t> unlabelled(0);
+
+    Clock::time_point start = Clock::now();
+    pool.Run(files.size(), [&](unsigned w, size_t task) {
+        Worker &worker = workers[w];
+        if (!mapTrace(files[task], &worker.trace, &worker.bytes)) {
+            worker.failed++;
+            return;
+        }
+        int expected = classOf(worker.trace.label);
+        if (expected < 0) {
+            unlabelled++;
+            return;
+        }
+        worker.samples += worker.trace.Samples();
+        replayWindows(worker.trace, &worker.windows);
+        for (size_t p = 0; p < params.size(); p++) {
+            evaluate(worker.windows, expected, worker.trace.reps, params[p], &worker.stats[p]);
+        }
+    });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<Stats> total(params.size(), Stats());
+    uint64_t samples = 0, bytes = 0, failed = 0;
+    for (size_t w = 0; w < workers.size(); w++) {
+        for (size_t p = 0; p < params.size(); p++) {
+            total[p].Add(workers[w].stats[p]);
+        }
+        samples += workers[w].samples;
+        bytes += workers[w].bytes;
+        failed += workers[w].failed;
+    }
+
+    printf("%zu files, %llu unreadable, %llu with an unknown label, %llu samples, %.1f MB\n",
+        files.size(), (unsigned long long)failed, (unsigned long long)unlabelled.load(),
+        (unsigned long long)samples, bytes / 1e6);
+    printf("%.3f s on %u threads (%llu steals), %.0f sets/s, %.1f M samples/s\n\n",
+        seconds, pool.Threads(), (unsigned long long)pool.Steals(),
+        files.size() / seconds, samples / seconds / 1e6);
+
+    size_t best = 0;
+    printf("%10s %6s %9s %9s %9s %9s\n", "confidence", "defer", "accuracy", "rep MAE", "rep bias", "exact");
+    for (size_t p = 0; p < params.size(); p++) {
+        const Stats &s = total[p];
+        double n = s.repSets ? (double)s.repSets : 1;
+        printf("%10s %6d %8.1f%% %9.2f %+9.2f %8.1f%%\n", confidenceName(params[p]).c_str(), params[p].deferLimit,
+            100 * s.Accuracy(), s.sumAbsRepError / n, s.sumRepError / n, 100 * s.exactReps / n);
+        if (s.Accuracy() > total[best].Accuracy()
+            || (s.Accuracy() == total[best].Accuracy() && s.sumAbsRepError < total[best].sumAbsRepError)) {
+            best = p;
+        }
+    }
+
+    printf("\n");
+    if (params.size() > 1) {
+        printf("best: confidence %s, defer %d\n", confidenceName(params[best]).c_str(), params[best].deferLimit);
+    }
+    printConfusion(total[best]);
+    return 0;
+}
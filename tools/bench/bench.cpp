@@ -0,0 +1,519 @@
+/*****************************************************************************
+File name: bench.cpp
+Description: Host micro-benchmarks of the driver math and the DSP hot paths,
+             with a JSON baseline and a regression gate
+Author: Junyu Bian
+Date: 10/18/2026
+
+Usage:
+    bench [--trace file.csv]... [--out results.json]
+          [--baseline tools/bench/baseline.json] [--threshold 15]
+          [--update-baseline]
+
+Exits with 1 when a benchmark is slower than its baseline by more than
+threshold percent.
+*****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "LIS3DSH.h"
+#include "MockLIS3DSH.h"
+#include "TraceFile.h"
+#include "Classifier.h"
+#include "MovingAverage.h"
+#include "SampleWindow.h"
+#include "PipelineStages.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const int16_t COUNTS_PER_G = LIS3DSH::CountsPerG(LIS3DSH::FS_2G);
+
+struct Result {
+    std::string name;
+    double nsPerOp;                     // median of the runs
+    double minNs, maxNs;                // spread of the runs
+    uint64_t iterations;
+};
+
+/* runs iterations of a benchmark, returns the elapsed time in nanoseconds */
+typedef double (*BenchFn)(void *ctx, uint64_t iterations);
+
+static volatile int32_t sink;           // keeps results alive
+
+static double elapsedNs(Clock::time_point start) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+/* grows the iteration count to at least 20 ms, then keeps the median of 5 runs */
+static Result measure(const std::string &name, BenchFn fn, void *ctx) {
+    uint64_t iterations = 1;
+    while (fn(ctx, iterations) < 20e6 && iterations < (1ULL << 40)) {
+        iterations *= 2;
+    }
+    std::vector<double> runs;
+    for (int i = 0; i < 5; i++) {
+        runs.push_back(fn(ctx, iterations) / iterations);
+    }
+    std::sort(runs.begin(), runs.end());
+    Result r = {name, runs[2], runs.front(), runs.back(), iterations};
+    fprintf(stderr, "%-32s %12.1f ns/op  (%.1f .. %.1f)\n", name.c_str(), r.nsPerOp, r.minNs, r.maxNs);
+    return r;
+}
+
+/* data set of a result name, the part after the last '/' */
+static std::string dataSetOf(const std::string &name) {
+    size_t slash = name.rfind('/');
+    return (slash == std::string::npos) ? "" : name.substr(slash + 1);
+}
+
+/* difference of the medians, and whether it is larger than the spread of the runs */
+static void printOverhead(const char *name, const Result &hand, const Result &pipeline) {
+    bool overlap = pipeline.minNs <= hand.maxNs && hand.minNs <= pipeline.maxNs;
+    fprintf(stderr, "pipeline overhead %-8s %+6.1f%%  hand %.1f .. %.1f, pipeline %.1f .. %.1f ns/op, %s\n",
+            name, 100.0 * (pipeline.nsPerOp / hand.nsPerOp - 1),
+            hand.minNs, hand.maxNs, pipeline.minNs, pipeline.maxNs,
+            overlap ? "within the spread" : "outside the spread");
+}
+
+/********** data sets ********************/
+
+struct DataSet {
+    std::string name;
+    Trace trace;
+    std::vector<SampleWindow> windows;  // filtered, as sampleTwoSeconds() builds them
+    std::vector<RawSample> samples;     // trace as pipeline input
+    size_t cursor;                      // next sample fed to the mock sensor
+};
+
+static void buildWindows(DataSet *data) {
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    for (size_t i = 0; i < data->trace.Samples(); i++) {
+        int16_t fx, fy, fz;
+        const int16_t *s = &data->trace.xyz[3*i];
+        filter.Push(s[0], s[1], s[2], &fx, &fy, &fz);
+        window.Push(fx, fy, fz);
+        if (window.Full()) {
+            data->windows.push_back(window);
+            window.Clear();
+        }
+        RawSample r = {s[0], s[1], s[2], 0};
+        data->samples.push_back(r);
+    }
+}
+
+static void traceSource(int16_t xyz[3], void *ctx) {
+    DataSet *data = (DataSet *)ctx;
+    const int16_t *s = &data->trace.xyz[3 * data->cursor];
+    xyz[0] = s[0];
+    xyz[1] = s[1];
+    xyz[2] = s[2];
+    if (++data->cursor >= data->trace.Samples()) {
+        data->cursor = 0;
+    }
+}
+
+/********** benchmarks ********************/
+
+struct Context {
+    DataSet *data;
+    MockLIS3DSH *device;
+    LIS3DSH *acc;
+};
+
+static double benchGToDegrees(void *ctx, uint64_t iterations) {
+    const std::vector<int16_t> &xyz = ((Context *)ctx)->data->trace.xyz;
+    size_t n = xyz.size() / 3;
+    float acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        const int16_t *s = &xyz[3 * (i % n)];
+        acc += LIS3DSH::gToDegrees(s[2] / -141.0f, s[0] / -141.0f);
+    }
+    double ns = elapsedNs(start);
+    sink = (int32_t)acc;
+    return ns;
+}
+
+static double benchReadAngles(void *ctx, uint64_t iterations) {
+    Context *c = (Context *)ctx;
+    float roll, pitch, acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        c->device->SetSample(c->data->trace.xyz[0], c->data->trace.xyz[1], c->data->trace.xyz[2]);
+        c->acc->ReadAngles(&roll, &pitch);
+        acc += roll + pitch;
+    }
+    double ns = elapsedNs(start);
+    sink = (int32_t)acc;
+    return ns;
+}
+
+/* batch conversions, one call per FIFO sized buffer (32 samples) */
+static const size_t BATCH = 32;
+
+static double benchToG(void *ctx, uint64_t iterations) {
+    Context *c = (Context *)ctx;
+    const std::vector<int16_t> &xyz = c->data->trace.xyz;
+    size_t batches = xyz.size() / 3 / BATCH;
+    float g[3 * BATCH];
+    float acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        c->acc->ToG(&xyz[3 * BATCH * (i % batches)], g, BATCH);
+        acc += g[0];
+    }
+    double ns = elapsedNs(start);
+    sink = (int32_t)acc;
+    return ns;
+}
+
+static double benchToRollPitch(void *ctx, uint64_t iterations) {
+    const std::vector<int16_t> &xyz = ((Context *)ctx)->data->trace.xyz;
+    size_t batches = xyz.size() / 3 / BATCH;
+    float roll[BATCH], pitch[BATCH];
+    float acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        LIS3DSH::ToRollPitch(&xyz[3 * BATCH * (i % batches)], roll, pitch, BATCH);
+        acc += roll[0] + pitch[0];
+    }
+    double ns = elapsedNs(start);
+    sink = (int32_t)acc;
+    return ns;
+}
+
+/* same work as sampling() in main.cpp: read, filter, append to the window */
+static double benchSampling(void *ctx, uint64_t iterations) {
+    Context *c = (Context *)ctx;
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        int16_t x, y, z, fx, fy, fz;
+        host_advance_ns(100000000);     // 0.1s between samples, latches a new one
+        c->acc->ReadData(&x, &y, &z);
+        filter.Push(x, y, z, &fx, &fy, &fz);
+        if (window.Full()) {
+            window.Clear();
+        }
+        window.Push(fx, fy, fz);
+    }
+    double ns = elapsedNs(start);
+    sink = window.Raw(0, AXIS_Y);
+    return ns;
+}
+
+/* sampling() in main.cpp before the pipeline: checked read, filter, append to the window */
+static double benchSamplingChecked(void *ctx, uint64_t iterations) {
+    Context *c = (Context *)ctx;
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        int16_t x, y, z, fx, fy, fz;
+        host_advance_ns(100000000);
+        c->acc->ReadChecked(&x, &y, &z);
+        filter.Push(x, y, z, &fx, &fy, &fz);
+        if (window.Full()) {
+            window.Clear();
+        }
+        window.Push(fx, fy, fz, (uint32_t)i);
+    }
+    double ns = elapsedNs(start);
+    sink = window.Raw(0, AXIS_Y);
+    return ns;
+}
+
+/* the same as samplingChecked through the acquisition pipeline of main.cpp */
+static double benchPipelineSampling(void *ctx, uint64_t iterations) {
+    Context *c = (Context *)ctx;
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    Pipeline<ReadStage, FilterStage, WindowStage> acquisition =
+        makePipeline(ReadStage(*c->acc), FilterStage(filter), WindowStage(window));
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        host_advance_ns(100000000);
+        acquisition.Push((uint32_t)i);
+    }
+    double ns = elapsedNs(start);
+    sink = window.Raw(0, AXIS_Y);
+    return ns;
+}
+
+static double benchFeatures(void *ctx, uint64_t iterations) {
+    const std::vector<SampleWindow> &windows = ((Context *)ctx)->data->windows;
+    int8_t features[MODEL_FEATURE_COUNT];
+    int32_t acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        extractFeatures(windows[i % windows.size()], features);
+        acc += features[0];
+    }
+    double ns = elapsedNs(start);
+    sink = acc;
+    return ns;
+}
+
+static double benchClassify(void *ctx, uint64_t iterations) {
+    const std::vector<SampleWindow> &windows = ((Context *)ctx)->data->windows;
+    std::vector<int8_t> features(windows.size() * MODEL_FEATURE_COUNT);
+    for (size_t w = 0; w < windows.size(); w++) {
+        extractFeatures(windows[w], &features[w * MODEL_FEATURE_COUNT]);
+    }
+    ClassifierResult result;
+    int32_t acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        classify(&features[(i % windows.size()) * MODEL_FEATURE_COUNT], &result);
+        acc += result.best;
+    }
+    double ns = elapsedNs(start);
+    sink = acc;
+    return ns;
+}
+
+static double benchCountPeaks(void *ctx, uint64_t iterations) {
+    const std::vector<SampleWindow> &windows = ((Context *)ctx)->data->windows;
+    int32_t acc = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        acc += windows[i % windows.size()].CountPeaks(AXIS_Y);
+    }
+    double ns = elapsedNs(start);
+    sink = acc;
+    return ns;
+}
+
+/* one whole window: 20 filtered samples, features, classification, reps */
+static double benchWindow(void *ctx, uint64_t iterations) {
+    const Trace &trace = ((Context *)ctx)->data->trace;
+    size_t n = trace.Samples();
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    ClassifierResult result;
+    int8_t features[MODEL_FEATURE_COUNT];
+    int32_t acc = 0;
+    size_t cursor = 0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        window.Clear();
+        for (int s = 0; s < SampleWindow::LENGTH; s++) {
+            int16_t fx, fy, fz;
+            const int16_t *raw = &trace.xyz[3 * cursor];
+            cursor = (cursor + 1 < n) ? cursor + 1 : 0;
+            filter.Push(raw[0], raw[1], raw[2], &fx, &fy, &fz);
+            window.Push(fx, fy, fz);
+        }
+        extractFeatures(window, features);
+        classify(features, &result);
+        acc += result.best + window.CountPeaks(AXIS_Y);
+    }
+    double ns = elapsedNs(start);
+    sink = acc;
+    return ns;
+}
+
+/* the same as window, one block of 20 samples pushed through
+   filter -> window -> features -> classification -> reps */
+static double benchPipelineWindow(void *ctx, uint64_t iterations) {
+    const std::vector<RawSample> &samples = ((Context *)ctx)->data->samples;
+    size_t n = samples.size();
+    MovingAverage filter;
+    SampleWindow window(COUNTS_PER_G);
+    int32_t acc = 0;
+    size_t cursor = 0;
+    auto pipeline = makePipeline(FilterStage(filter), WindowStage(window), FeatureStage(),
+                                 ClassifyStage(), PeakStage(AXIS_Y),
+                                 makeSink([&acc](const WindowResult &r) { acc += r.result.best + r.reps; }));
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        if (cursor + SampleWindow::LENGTH > n) {
+            cursor = 0;
+        }
+        pipeline.PushBlock(&samples[cursor], SampleWindow::LENGTH);
+        cursor += SampleWindow::LENGTH;
+    }
+    double ns = elapsedNs(start);
+    sink = acc;
+    return ns;
+}
+
+/********** JSON ********************/
+
+static void writeJson(FILE *f, const std::vector<Result> &results) {
+    fprintf(f, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"iterations\": %llu}%s\n",
+                results[i].name.c_str(), results[i].nsPerOp,
+                (unsigned long long)results[i].iterations, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+/* reads the name / ns_per_op pairs back from a file written by writeJson() */
+static bool readBaseline(const char *path, std::map<std::string, double> *baseline) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char name[256];
+        double ns;
+        const char *p = strstr(line, "\"name\"");
+        if (p && sscanf(p, "\"name\": \"%255[^\"]\", \"ns_per_op\": %lf", name, &ns) == 2) {
+            (*baseline)[name] = ns;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static std::string baseName(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == std::string::npos) ? name : name.substr(0, dot);
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> tracePaths;
+    const char *out = NULL;
+    const char *baselinePath = NULL;
+    double threshold = 15.0;
+    bool update = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            tracePaths.push_back(argv[++i]);
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            out = argv[++i];
+        } else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--update-baseline")) {
+            update = true;
+        } else {
+            fprintf(stderr, "usage: %s [--trace file]... [--out file] [--baseline file] "
+                            "[--threshold percent] [--update-baseline]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<DataSet> sets(1 + tracePaths.size());
+    sets[0].name = "synthetic";
+    sets[0].trace = syntheticTrace(2000, 25, 6483);
+    for (size_t i = 0; i < tracePaths.size(); i++) {
+        sets[i + 1].name = baseName(tracePaths[i]);
+        if (!loadTrace(tracePaths[i], &sets[i + 1].trace)) {
+            fprintf(stderr, "cannot read trace %s\n", tracePaths[i].c_str());
+            return 2;
+        }
+    }
+
+    MockLIS3DSH device;
+    device.Attach(PE_3);
+    LIS3DSH acc(PA_7, SPI_MISO, SPI_SCK, PE_3);
+    if (acc.Begin(100000) != 0) {
+        fprintf(stderr, "simulated accelerometer did not start\n");
+        return 2;
+    }
+
+    std::vector<Result> results;
+    for (size_t i = 0; i < sets.size(); i++) {
+        DataSet &data = sets[i];
+        data.cursor = 0;
+        buildWindows(&data);
+        if (data.windows.empty()) {
+            fprintf(stderr, "trace %s is shorter than one window\n", data.name.c_str());
+            return 2;
+        }
+        device.SetSource(traceSource, &data);
+        Context ctx = {&data, &device, &acc};
+        const std::string suffix = "/" + data.name;
+        results.push_back(measure("gToDegrees" + suffix, benchGToDegrees, &ctx));
+        results.push_back(measure("ReadAngles" + suffix, benchReadAngles, &ctx));
+        results.push_back(measure("ToG/32" + suffix, benchToG, &ctx));
+        results.push_back(measure("ToRollPitch/32" + suffix, benchToRollPitch, &ctx));
+        results.push_back(measure("sampling" + suffix, benchSampling, &ctx));
+        results.push_back(measure("extractFeatures" + suffix, benchFeatures, &ctx));
+        results.push_back(measure("classify" + suffix, benchClassify, &ctx));
+        results.push_back(measure("CountPeaks" + suffix, benchCountPeaks, &ctx));
+        results.push_back(measure("window" + suffix, benchWindow, &ctx));
+        results.push_back(measure("samplingChecked" + suffix, benchSamplingChecked, &ctx));
+        results.push_back(measure("pipelineSampling" + suffix, benchPipelineSampling, &ctx));
+        results.push_back(measure("pipelineWindow" + suffix, benchPipelineWindow, &ctx));
+
+        /* the pipelines against the same work written out by hand */
+        size_t last = results.size() - 1;
+        printOverhead("sampling", results[last - 2], results[last - 1]);
+        printOverhead("window", results[last - 3], results[last]);
+    }
+
+    if (out != NULL) {
+        FILE *f = fopen(out, "w");
+        if (f == NULL) {
+            fprintf(stderr, "cannot write %s\n", out);
+            return 2;
+        }
+        writeJson(f, results);
+        fclose(f);
+    } else {
+        writeJson(stdout, results);
+    }
+
+    if (baselinePath == NULL) {
+        return 0;
+    }
+    if (update) {
+        FILE *f = fopen(baselinePath, "w");
+        if (f == NULL) {
+            fprintf(stderr, "cannot write %s\n", baselinePath);
+            return 2;
+        }
+        writeJson(f, results);
+        fclose(f);
+        return 0;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!readBaseline(baselinePath, &baseline)) {
+        fprintf(stderr, "cannot read baseline %s\n", baselinePath);
+        return 2;
+    }
+    /* a data set the baseline covers must cover every benchmark, a new one
+       without an entry would never be gated; other data sets (--trace) only warn */
+    std::set<std::string> baselineSets;
+    for (std::map<std::string, double>::const_iterator b = baseline.begin(); b != baseline.end(); ++b) {
+        baselineSets.insert(dataSetOf(b->first));
+    }
+    int regressions = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        std::map<std::string, double>::const_iterator b = baseline.find(results[i].name);
+        if (b == baseline.end()) {
+            bool covered = baselineSets.count(dataSetOf(results[i].name)) != 0;
+            fprintf(stderr, "%s %s: not in the baseline, record it with --update-baseline\n",
+                    covered ? "MISSING" : "warning", results[i].name.c_str());
+            regressions += covered;
+            continue;
+        }
+        double change = 100.0 * (results[i].nsPerOp - b->second) / b->second;
+        if (change > threshold) {
+            fprintf(stderr, "REGRESSION %s: %.1f -> %.1f ns/op (%+.1f%% > %.1f%%)\n",
+                    results[i].name.c_str(), b->second, results[i].nsPerOp, change, threshold);
+            regressions++;
+        }
+    }
+    return regressions ? 1 : 0;
+}
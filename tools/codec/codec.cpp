@@ -0,0 +1,246 @@
+/*****************************************************************************
+File name: codec.cpp
+Description: Host side of the sample codec: compression ratio and throughput
+             on traces, and decoding of captures streamed by the board
+Author: Junyu Bian
+Date: 10/18/2026
+
+Usage:
+    codec bench [--trace file.csv]... [--block 64]
+    codec decode capture.bin trace.csv [--label situps] [--reps 5]
+
+bench exits with 1 when a round trip is not lossless.
+*****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "SampleCodec.h"
+#include "TraceFile.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const char *PREDICTOR_NAMES[] = {"delta", "linear"};
+
+/* encodes a whole trace as consecutive blocks */
+static size_t encodeTrace(const Trace &trace, Predictor predictor, size_t block, std::vector<uint8_t> *out) {
+    SampleEncoder encoder(predictor);
+    size_t n = trace.Samples();
+    size_t pos = 0;
+
+    out->resize((n / block + 1) * CODEC_MAX_BLOCK_BYTES(block));
+    for (size_t i = 0; i < n; i += block) {
+        size_t end = std::min(n, i + block);
+        encoder.Begin(&(*out)[pos], CODEC_MAX_BLOCK_BYTES(block));
+        for (size_t s = i; s < end; s++) {
+            encoder.Push(&trace.xyz[3 * s]);
+        }
+        pos += encoder.Finish();
+    }
+    return pos;
+}
+
+/* decodes consecutive blocks, returns the number of samples or -1 */
+static long decodeStream(const uint8_t *data, size_t length, int16_t *xyz, size_t maxSamples) {
+    size_t pos = 0, samples = 0;
+
+    while (pos < length) {
+        size_t used;
+        int n = decodeBlock(data + pos, length - pos, xyz + 3 * samples, maxSamples - samples, &used);
+        if (n < 0) {
+            return -1;
+        }
+        pos += used;
+        samples += n;
+    }
+    return (long)samples;
+}
+
+/* median over 5 runs of a loop grown to at least 20 ms, in seconds per call */
+template <typename F>
+static double timeIt(F fn) {
+    uint64_t iterations = 1;
+    for (;;) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            fn();
+        }
+        if (std::chrono::duration<double>(Clock::now() - start).count() >= 0.02) {
+            break;
+        }
+        iterations *= 2;
+    }
+    std::vector<double> runs;
+    for (int r = 0; r < 5; r++) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            fn();
+        }
+        runs.push_back(std::chrono::duration<double>(Clock::now() - start).count() / iterations);
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs[2];
+}
+
+static bool benchTrace(const std::string &name, const Trace &trace, size_t block) {
+    size_t n = trace.Samples();
+    double raw = (double)n * 3 * sizeof(int16_t);
+    bool ok = true;
+
+    for (int p = PREDICT_DELTA; p <= PREDICT_LINEAR; p++) {
+        std::vector<uint8_t> encoded;
+        std::vector<int16_t> decoded(trace.xyz.size());
+        size_t bytes = encodeTrace(trace, (Predictor)p, block, &encoded);
+
+        long samples = decodeStream(encoded.data(), bytes, decoded.data(), n);
+        if (samples != (long)n || decoded != trace.xyz) {
+            fprintf(stderr, "%s/%s: round trip FAILED\n", name.c_str(), PREDICTOR_NAMES[p]);
+            ok = false;
+            continue;
+        }
+
+        std::vector<uint8_t> scratch;
+        double encodeS = timeIt([&]() { encodeTrace(trace, (Predictor)p, block, &scratch); });
+        double decodeS = timeIt([&]() { decodeStream(encoded.data(), bytes, decoded.data(), n); });
+        printf("%-24s %-6s %8zu samples %9zu -> %8zu bytes  ratio %5.2f  %5.2f bits/axis  "
+               "encode %7.1f MB/s  decode %7.1f MB/s\n",
+               name.c_str(), PREDICTOR_NAMES[p], n, (size_t)raw, bytes, raw / bytes,
+               8.0 * bytes / (3.0 * n), raw / encodeS / 1e6, raw / decodeS / 1e6);
+    }
+    return ok;
+}
+
+static int bench(int argc, char **argv) {
+    std::vector<std::string> paths;
+    size_t block = 64;
+
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            paths.push_back(argv[++i]);
+        } else if (!strcmp(argv[i], "--block") && i + 1 < argc) {
+            block = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: codec bench [--trace file]... [--block samples]\n");
+            return 2;
+        }
+    }
+    if (block < 1 || block > 0xFFFF || CODEC_MAX_BLOCK_BYTES(block) > CODEC_HEADER_BYTES + 0xFFFF) {
+        fprintf(stderr, "block must be 1 - %d samples\n", 0xFFFF * 8 / CODEC_MAX_SAMPLE_BITS);
+        return 2;
+    }
+
+    bool ok = benchTrace("synthetic", syntheticTrace(20000, 25, 6483), block);
+    ok = benchTrace("synthetic-slow", syntheticTrace(20000, 250, 6483), block) && ok;
+    for (size_t i = 0; i < paths.size(); i++) {
+        Trace trace;
+        if (!loadTrace(paths[i], &trace)) {
+            fprintf(stderr, "cannot read trace %s\n", paths[i].c_str());
+            return 2;
+        }
+        ok = benchTrace(paths[i], trace, block) && ok;
+    }
+    return ok ? 0 : 1;
+}
+
+static int decode(int argc, char **argv) {
+    const char *label = NULL;
+    int reps = -1;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: codec decode capture.bin trace.csv [--label name] [--reps n]\n");
+        return 2;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--label") && i + 1 < argc) {
+            label = argv[++i];
+        } else if (!strcmp(argv[i], "--reps") && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    FILE *in = fopen(argv[0], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "cannot read %s\n", argv[0]);
+        return 2;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(in);
+
+    /* the terminal may have caught text before the capture started */
+    const uint8_t *magic = (const uint8_t *)CODEC_STREAM_MAGIC;
+    std::vector<uint8_t>::iterator start = std::search(data.begin(), data.end(), magic, magic + 4);
+    if (data.end() - start < 8) {
+        fprintf(stderr, "%s: no capture found\n", argv[0]);
+        return 1;
+    }
+    size_t pos = (start - data.begin()) + 4;
+    uint32_t period;
+    memcpy(&period, &data[pos], sizeof(period));
+    pos += sizeof(period);
+
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 2;
+    }
+    if (label != NULL) {
+        fprintf(out, "# label: %s\n", label);
+    }
+    if (reps >= 0) {
+        fprintf(out, "# reps: %d\n", reps);
+    }
+
+    std::vector<int16_t> xyz(3 * 0xFFFF);
+    uint64_t samples = 0;
+    bool ended = false;
+    while (pos < data.size()) {
+        size_t used;
+        int count = decodeBlock(&data[pos], data.size() - pos, xyz.data(), 0xFFFF, &used);
+        if (count < 0) {
+            break;
+        }
+        pos += used;
+        if (count == 0) {
+            ended = true;
+            break;
+        }
+        for (int i = 0; i < count; i++, samples++) {
+            fprintf(out, "%llu,%d,%d,%d\n", (unsigned long long)(samples * period),
+                    xyz[3*i], xyz[3*i + 1], xyz[3*i + 2]);
+        }
+    }
+    fclose(out);
+
+    fprintf(stderr, "%llu samples, %u us apart, %zu bytes (%.2fx)\n", (unsigned long long)samples,
+            period, pos - (start - data.begin()), samples * 6.0 / (pos - (start - data.begin())));
+    if (!ended) {
+        fprintf(stderr, "capture truncated or corrupt, kept the samples before it\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && !strcmp(argv[1], "bench")) {
+        return bench(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && !strcmp(argv[1], "decode")) {
+        return decode(argc - 2, argv + 2);
+    }
+    fprintf(stderr, "usage: %s bench [--trace file]... [--block samples]\n"
+                    "       %s decode capture.bin trace.csv [--label name] [--reps n]\n", argv[0], argv[0]);
+    return 2;
+}
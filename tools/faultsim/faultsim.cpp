@@ -0,0 +1,199 @@
+/*****************************************************************************
+File name: faultsim.cpp
+Description: Injects sensor and bus faults into the simulated LIS3DSH and
+             measures how long LIS3DSH::ReadChecked() takes to detect them
+             and stream again
+Author: Junyu Bian
+Date: 10/18/2026
+
+Usage:
+    faultsim [--faults 200] [--period-us 100000] [--limit-ms 3000] [--seed 1]
+
+For every fault kind the driver reads on the sampling period of the
+firmware, the fault starts at a random time and the latency is measured from
+there to the first new sample after the re-initialization. A fault free run
+of the same length checks that nothing is detected without a fault. Exits
+with 1 when a fault is not recovered within limit-ms or a false fault is seen.
+*****************************************************************************/
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "LIS3DSH.h"
+#include "MockLIS3DSH.h"
+
+static uint32_t rng = 1;
+
+static uint32_t next(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/* a slow swing with +/- 32 counts of noise, like a board held in the hand */
+static void noisySource(int16_t xyz[3], void *ctx) {
+    uint32_t *n = (uint32_t *)ctx;
+    double phase = 2 * 3.14159265 * (*n)++ / 25;
+    xyz[0] = (int16_t)(1500 + (int)(next() & 63) - 32);
+    xyz[1] = (int16_t)(4000 * sin(phase) + (int)(next() & 63) - 32);
+    xyz[2] = (int16_t)(-15000 + (int)(next() & 63) - 32);
+}
+
+struct Outcome {
+    const char *name;
+    std::vector<uint32_t> latencyUs;
+    uint32_t unrecovered;
+    uint32_t maxCallUs;
+    LIS3DSHHealth health;
+};
+
+/* longest single ReadChecked() call, i.e. how long a recovery attempt blocks the sampling loop */
+static uint32_t maxCallUs;
+
+static int timedRead(LIS3DSH &acc, int16_t *x, int16_t *y, int16_t *z) {
+    uint32_t start = us_ticker_read();
+    int result = acc.ReadChecked(x, y, z);
+    uint32_t took = us_ticker_read() - start;
+    maxCallUs = took > maxCallUs ? took : maxCallUs;
+    return result;
+}
+
+/* reads on the period until the driver reports a recovery, returns false after limitUs */
+static bool waitRecovery(LIS3DSH &acc, uint32_t periodUs, uint32_t limitUs, uint32_t *latencyUs) {
+    uint32_t start = us_ticker_read();
+    int16_t x, y, z;
+
+    while (us_ticker_read() - start < limitUs) {
+        if (timedRead(acc, &x, &y, &z) == -1) {
+            *latencyUs = us_ticker_read() - start;
+            return true;
+        }
+        wait_us(periodUs);
+    }
+    return false;
+}
+
+static Outcome run(const char *name, MockLIS3DSH::Fault fault, uint32_t faults,
+                   uint32_t periodUs, uint32_t limitUs) {
+    Outcome outcome;
+    uint32_t n = 0;
+    int16_t x, y, z;
+
+    outcome.name = name;
+    outcome.unrecovered = 0;
+    maxCallUs = 0;
+
+    MockLIS3DSH device;
+    device.Attach(PE_3);
+    device.SetSource(noisySource, &n);
+    LIS3DSH acc(PA_7, SPI_MISO, SPI_SCK, PE_3);
+    if (acc.Begin(100000) != 0) {
+        fprintf(stderr, "simulated accelerometer did not start\n");
+        exit(2);
+    }
+    int8_t offset[3] = {3, -2, 5};
+    acc.SetOffsets(offset);
+
+    for (uint32_t i = 0; i < faults; i++) {
+        /* streaming for 1 - 3 s, then the fault starts between two reads */
+        uint32_t reads = 10 + next() % 20;
+        for (uint32_t r = 0; r < reads; r++) {
+            timedRead(acc, &x, &y, &z);
+            wait_us(periodUs);
+        }
+        if (fault == MockLIS3DSH::FAULT_NONE) {
+            continue;
+        }
+        wait_us(next() % periodUs);
+        /* a bus fault ends by itself after 10 - 500 ms, the others need a reset */
+        device.InjectFault(fault, fault == MockLIS3DSH::FAULT_BUS ? 10000 + next() % 490000 : 0);
+
+        uint32_t latency;
+        if (waitRecovery(acc, periodUs, limitUs, &latency)) {
+            outcome.latencyUs.push_back(latency);
+        } else {
+            outcome.unrecovered++;
+            device.InjectFault(MockLIS3DSH::FAULT_NONE);
+            waitRecovery(acc, periodUs, 10 * limitUs, &latency);
+        }
+    }
+    outcome.health = acc.Health();
+    outcome.maxCallUs = maxCallUs;
+    return outcome;
+}
+
+int main(int argc, char **argv) {
+    uint32_t faults = 200;
+    uint32_t periodUs = 100000;
+    uint32_t limitMs = 3000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--faults") && i + 1 < argc) {
+            faults = (uint32_t)atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--period-us") && i + 1 < argc) {
+            periodUs = (uint32_t)atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--limit-ms") && i + 1 < argc) {
+            limitMs = (uint32_t)atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            rng = (uint32_t)atol(argv[++i]);
+            rng = rng ? rng : 1;
+        } else {
+            fprintf(stderr, "usage: %s [--faults n] [--period-us us] [--limit-ms ms] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (periodUs == 0) {
+        periodUs = 1;
+    }
+
+    static const struct {
+        const char *name;
+        MockLIS3DSH::Fault fault;
+    } KINDS[] = {
+        {"none", MockLIS3DSH::FAULT_NONE},
+        {"stall", MockLIS3DSH::FAULT_STALL},
+        {"frozen", MockLIS3DSH::FAULT_FROZEN},
+        {"identity", MockLIS3DSH::FAULT_IDENTITY},
+        {"bus", MockLIS3DSH::FAULT_BUS},
+    };
+
+    int status = 0;
+    printf("%-9s %6s %7s %9s %9s %9s %9s %9s  %s\n", "fault", "faults", "missed",
+           "min ms", "mean ms", "p99 ms", "max ms", "block ms", "stalls/frozen/identity/bus, recoveries (failed)");
+    for (size_t k = 0; k < sizeof(KINDS) / sizeof(KINDS[0]); k++) {
+        Outcome o = run(KINDS[k].name, KINDS[k].fault, faults, periodUs, limitMs * 1000);
+        std::vector<uint32_t> &l = o.latencyUs;
+        std::sort(l.begin(), l.end());
+        double sum = 0;
+        for (size_t i = 0; i < l.size(); i++) {
+            sum += l[i];
+        }
+        const LIS3DSHHealth &h = o.health;
+        if (l.empty()) {
+            printf("%-9s %6u %7u %9s %9s %9s %9s", o.name, KINDS[k].fault ? faults : 0, o.unrecovered,
+                   "-", "-", "-", "-");
+        } else {
+            printf("%-9s %6u %7u %9.1f %9.1f %9.1f %9.1f", o.name, faults, o.unrecovered,
+                   l.front() / 1000.0, sum / l.size() / 1000.0,
+                   l[(l.size() * 99) / 100 < l.size() ? (l.size() * 99) / 100 : l.size() - 1] / 1000.0,
+                   l.back() / 1000.0);
+        }
+        printf(" %9.1f  %u/%u/%u/%u, %u (%u)\n", o.maxCallUs / 1000.0, h.stalls, h.frozen, h.identityErrors, h.busErrors,
+               h.recoveries, h.failedRecoveries);
+
+        if (o.unrecovered > 0) {
+            fprintf(stderr, "%s: %u faults not recovered within %u ms\n", o.name, o.unrecovered, limitMs);
+            status = 1;
+        }
+        if (KINDS[k].fault == MockLIS3DSH::FAULT_NONE && h.recoveries + h.failedRecoveries > 0) {
+            fprintf(stderr, "false fault detected without injection\n");
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,219 @@
+/*****************************************************************************
+File name: flashsim.cpp
+Description: Runs the session log on a file backed flash image and reports
+             write amplification, wear spread, recovery time and power loss
+             behaviour, also during the rotation of a sector
+Author: Junyu Bian
+Date: 10/18/2026
+
+Usage:
+    flashsim [--image flashsim.img] [--records 20000] [--sectors 3]
+             [--sector-size 131072] [--power-cuts 100]
+*****************************************************************************/
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FileFlash.h"
+#include "SessionLog.h"
+
+static const uint32_t BASE = 0x080A0000;    // same place as on the board
+
+static double mountUs(SessionLog &log) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    log.Mount();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static SessionEntry entry(uint32_t i) {
+    SessionEntry e;
+    e.uptimeMs = i * 60000;
+    e.durationMs = 30000 + i % 1000;
+    e.mode = (uint8_t)(i % 2);
+    e.exercise = (uint8_t)(i % 4);
+    e.reps = 5;
+    return e;
+}
+
+/* record of a type carrying a 4 byte tag, for the rotation test */
+static int appendTag(SessionLog &log, uint8_t type, uint32_t tag) {
+    return log.Append(type, &tag, sizeof(tag));
+}
+
+static bool latestIs(SessionLog &log, uint8_t type, uint32_t tag) {
+    LogRecord record;
+    uint32_t value;
+    if (!log.ReadLatest(type, &record) || record.length != sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, record.payload, sizeof(value));
+    return value == tag;
+}
+
+int main(int argc, char **argv) {
+    const char *image = "flashsim.img";
+    uint32_t records = 20000;
+    uint32_t sectors = 3;
+    uint32_t sectorSize = 131072;
+    uint32_t powerCuts = 100;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--image") && i + 1 < argc) {
+            image = argv[++i];
+        } else if (!strcmp(argv[i], "--records") && i + 1 < argc) {
+            records = (uint32_t)atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--sectors") && i + 1 < argc) {
+            sectors = (uint32_t)atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--sector-size") && i + 1 < argc) {
+            sectorSize = (uint32_t)atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--power-cuts") && i + 1 < argc) {
+            powerCuts = (uint32_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--image file] [--records n] [--sectors n] "
+                            "[--sector-size bytes] [--power-cuts n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (sectors < 2 || sectors > 255 || sectorSize < 2 * LOG_RECORD_SIZE) {
+        fprintf(stderr, "need 2 - 255 sectors of at least %d bytes\n", 2 * LOG_RECORD_SIZE);
+        return 2;
+    }
+
+    remove(image);
+    FileFlash flash(image, BASE, sectorSize, sectors);
+    SessionLog log(flash, BASE, sectorSize, (uint8_t)sectors);
+    log.Mount();
+    flash.ResetCounters();
+
+    /********** write amplification and wear ********************/
+    for (uint32_t i = 0; i < records; i++) {
+        SessionEntry e = entry(i);
+        if (log.Append(RECORD_SESSION, &e, sizeof(e)) != 0) {
+            fprintf(stderr, "append %u failed\n", i);
+            return 1;
+        }
+    }
+    double logical = (double)records * sizeof(SessionEntry);
+    uint32_t minErases = UINT32_MAX, maxErases = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        uint32_t e = flash.SectorErases(s);
+        minErases = e < minErases ? e : minErases;
+        maxErases = e > maxErases ? e : maxErases;
+    }
+    printf("records            %u x %u payload bytes in %u sectors of %u bytes\n",
+           records, (unsigned)sizeof(SessionEntry), sectors, sectorSize);
+    printf("programmed bytes   %llu (%.2fx payload)\n",
+           (unsigned long long)flash.ProgrammedBytes(), flash.ProgrammedBytes() / logical);
+    printf("erased bytes       %llu (%.2fx payload)\n",
+           (unsigned long long)flash.ErasedBytes(), flash.ErasedBytes() / logical);
+    printf("sector erases      min %u max %u\n", minErases, maxErases);
+    printf("readable records   %u of %u\n", log.Size(), log.Sequence());
+
+    /********** recovery ********************/
+    SessionLog fresh(flash, BASE, sectorSize, (uint8_t)sectors);
+    flash.ResetCounters();
+    double us = mountUs(fresh);
+    printf("mount              %.1f us, %u reads, %llu bytes (linear scan: %u reads)\n",
+           us, fresh.MountReads(), (unsigned long long)flash.ReadBytes(),
+           sectors + sectorSize / LOG_RECORD_SIZE);
+    if (fresh.Sequence() != log.Sequence()) {
+        fprintf(stderr, "recovered sequence %u, expected %u\n", fresh.Sequence(), log.Sequence());
+        return 1;
+    }
+
+    /********** power loss ********************/
+    uint32_t recovered = 0;
+    srand(6483);
+    for (uint32_t i = 0; i < powerCuts; i++) {
+        uint32_t before = fresh.Sequence();
+        SessionEntry e = entry(before);
+        flash.CutPowerAfter((uint64_t)(rand() % LOG_RECORD_SIZE));
+        fresh.Append(RECORD_SESSION, &e, sizeof(e));
+        flash.PowerOn();
+
+        SessionLog rebooted(flash, BASE, sectorSize, (uint8_t)sectors);
+        rebooted.Mount();
+        LogRecord newest;
+        bool torn = !rebooted.Read(0, &newest);
+        bool older = rebooted.Read(1, &newest) && newest.sequence + 2 == rebooted.Sequence();
+        /* the torn slot is either unused (nothing programmed) or skipped */
+        if ((torn && older) || rebooted.Sequence() == before) {
+            recovered++;
+        }
+        SessionEntry next = entry(rebooted.Sequence());
+        rebooted.Append(RECORD_SESSION, &next, sizeof(next));
+        fresh.Mount();
+    }
+    printf("power cuts         %u of %u recovered\n", recovered, powerCuts);
+
+    /********** power loss during rotation ********************/
+    /* each cut hits the append that rotates the ring: while the kept records
+       are copied, during the erase of the oldest sector (with or without its
+       header) or between the erase and the new header. The newest record of
+       every type must survive the reset and the rotation finished after it. */
+    SessionLog ring(flash, BASE, sectorSize, (uint8_t)sectors);
+    ring.Keep(RECORD_CALIBRATION);
+    ring.Keep(RECORD_BURST);
+    ring.Format();
+    uint32_t tag = 1;
+    uint32_t latest[4] = {0, 0, 0, 0};      // newest tag by RecordType
+    for (uint8_t type = RECORD_SESSION; type <= RECORD_BURST; type++) {
+        appendTag(ring, type, tag);
+        latest[type] = tag++;
+    }
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < powerCuts; i++) {
+        /* fill the active sector, now and then with a new kept record */
+        uint32_t calibrationAt = (rand() % 4 == 0) ? rand() % (ring.Free() + 1) : UINT32_MAX;
+        uint32_t burstAt = (rand() % 4 == 0) ? rand() % (ring.Free() + 1) : UINT32_MAX;
+        for (uint32_t n = 0; ring.Free() > 0; n++) {
+            uint8_t type = (n == calibrationAt) ? RECORD_CALIBRATION
+                         : (n == burstAt) ? RECORD_BURST : RECORD_SESSION;
+            appendTag(ring, type, tag);
+            latest[type] = tag++;
+        }
+
+        switch (i % 3) {
+        case 0:     /* copies, header or the record itself */
+            flash.CutPowerAfter((uint64_t)(rand() % (4 * LOG_RECORD_SIZE)));
+            break;
+        case 1:     /* anywhere in the erase */
+            flash.CutPowerInErase(rand() % sectorSize, rand() % sectorSize);
+            break;
+        default:    /* erase that leaves the sector header intact */
+            flash.CutPowerInErase(LOG_RECORD_SIZE + rand() % (sectorSize - LOG_RECORD_SIZE),
+                                  rand() % sectorSize);
+            break;
+        }
+        uint32_t cutTag = tag++;
+        appendTag(ring, RECORD_SESSION, cutTag);
+        flash.PowerOn();
+
+        SessionLog rebooted(flash, BASE, sectorSize, (uint8_t)sectors);
+        rebooted.Keep(RECORD_CALIBRATION);
+        rebooted.Keep(RECORD_BURST);
+        rebooted.Mount();
+        bool ok = latestIs(rebooted, RECORD_CALIBRATION, latest[RECORD_CALIBRATION])
+               && latestIs(rebooted, RECORD_BURST, latest[RECORD_BURST])
+               && (latestIs(rebooted, RECORD_SESSION, latest[RECORD_SESSION])
+                   || latestIs(rebooted, RECORD_SESSION, cutTag));
+
+        /* finish the rotation without a cut */
+        appendTag(rebooted, RECORD_SESSION, tag);
+        latest[RECORD_SESSION] = tag++;
+        ok = ok && latestIs(rebooted, RECORD_CALIBRATION, latest[RECORD_CALIBRATION])
+                && latestIs(rebooted, RECORD_BURST, latest[RECORD_BURST])
+                && latestIs(rebooted, RECORD_SESSION, latest[RECORD_SESSION]);
+        if (ok) {
+            kept++;
+        } else {
+            fprintf(stderr, "rotation cut %u lost a record\n", i);
+        }
+        ring.Mount();
+    }
+    printf("rotation cuts      %u of %u kept the newest record of each type\n", kept, powerCuts);
+    remove(image);
+    return (recovered == powerCuts && kept == powerCuts) ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+/*****************************************************************************
+File name: FileFlash.cpp
+Description: File backed NOR flash simulator implementing FlashDevice, with
+             wear counters and power loss injection
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "FileFlash.h"
+#include <string.h>
+
+FileFlash::FileFlash(const std::string &path, uint32_t base, uint32_t sectorSize, uint32_t sectors)
+: _file(NULL), _base(base), _sectorSize(sectorSize), _image((size_t)sectorSize * sectors, 0xFF),
+  _erases(sectors, 0), _powerCut(false), _budget(0), _eraseCut(false), _eraseCutOffset(0),
+  _eraseCutLength(0)
+{
+    ResetCounters();
+    _file = fopen(path.c_str(), "r+b");
+    if (_file != NULL) {
+        size_t n = fread(&_image[0], 1, _image.size(), _file);
+        (void)n;                    // a short file keeps the erased tail
+    } else {
+        _file = fopen(path.c_str(), "w+b");
+        Flush(0, (uint32_t)_image.size());
+    }
+}
+
+FileFlash::~FileFlash() {
+    if (_file != NULL) {
+        fclose(_file);
+    }
+}
+
+void FileFlash::ResetCounters(void) {
+    _readBytes = 0;
+    _programmedBytes = 0;
+    _erasedBytes = 0;
+}
+
+void FileFlash::CutPowerAfter(uint64_t bytes) {
+    _powerCut = true;
+    _budget = bytes;
+}
+
+void FileFlash::CutPowerInErase(uint32_t offset, uint32_t length) {
+    _eraseCut = true;
+    _eraseCutOffset = offset;
+    _eraseCutLength = length;
+}
+
+void FileFlash::PowerOn(void) {
+    _powerCut = false;
+    _eraseCut = false;
+}
+
+bool FileFlash::InRange(uint32_t addr, uint32_t size) const {
+    return addr >= _base && (uint64_t)addr - _base + size <= _image.size();
+}
+
+void FileFlash::Flush(uint32_t offset, uint32_t size) {
+    if (_file == NULL) {
+        return;
+    }
+    fseek(_file, offset, SEEK_SET);
+    fwrite(&_image[offset], 1, size, _file);
+    fflush(_file);
+}
+
+int FileFlash::Read(uint32_t addr, void *buffer, uint32_t size) {
+    if (!InRange(addr, size)) {
+        return -1;
+    }
+    memcpy(buffer, &_image[addr - _base], size);
+    _readBytes += size;
+    return 0;
+}
+
+int FileFlash::Program(uint32_t addr, const void *buffer, uint32_t size) {
+    if (!InRange(addr, size)) {
+        return -1;
+    }
+    uint32_t n = size;
+    if (_powerCut) {
+        n = (_budget < size) ? (uint32_t)_budget : size;
+        _budget -= n;
+    }
+    const uint8_t *p = (const uint8_t *)buffer;
+    uint32_t offset = addr - _base;
+    for (uint32_t i = 0; i < n; i++) {
+        _image[offset + i] &= p[i];         // programming only clears bits
+    }
+    _programmedBytes += n;
+    Flush(offset, n);
+    return (n == size) ? 0 : -1;
+}
+
+int FileFlash::Erase(uint32_t addr, uint32_t size) {
+    if (!InRange(addr, size) || (addr - _base) % _sectorSize != 0 || size % _sectorSize != 0) {
+        return -1;
+    }
+    if (_powerCut && _budget == 0) {
+        return -1;
+    }
+    uint32_t offset = addr - _base;
+    if (_eraseCut) {
+        uint32_t start = _eraseCutOffset < size ? _eraseCutOffset : size;
+        uint32_t n = _eraseCutLength < size - start ? _eraseCutLength : size - start;
+        memset(&_image[offset + start], 0xFF, n);
+        _erasedBytes += n;
+        Flush(offset + start, n);
+        _eraseCut = false;
+        _powerCut = true;
+        _budget = 0;
+        return -1;
+    }
+    memset(&_image[offset], 0xFF, size);
+    for (uint32_t s = offset / _sectorSize; s < (offset + size) / _sectorSize; s++) {
+        _erases[s]++;
+    }
+    _erasedBytes += size;
+    Flush(offset, size);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*****************************************************************************
+File name: FileFlash.h
+Description: File backed NOR flash simulator implementing FlashDevice, with
+             wear counters and power loss injection
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef FILEFLASH_H
+#define FILEFLASH_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "SessionLog.h"
+
+/** Flash image kept in a file. Programming ANDs bits in, like NOR flash,
+ *  erasing fills a sector with 0xFF. Sectors are equally sized.
+ */
+class FileFlash : public FlashDevice {
+  public:
+    /** Opens (or creates, erased) an image of sectors * sectorSize bytes at base. */
+    FileFlash(const std::string &path, uint32_t base, uint32_t sectorSize, uint32_t sectors);
+    ~FileFlash();
+
+    virtual int Read(uint32_t addr, void *buffer, uint32_t size);
+    virtual int Program(uint32_t addr, const void *buffer, uint32_t size);
+    virtual int Erase(uint32_t addr, uint32_t size);
+
+    /** Simulates a reset: only the next bytes bytes get programmed, after that
+     *  every Program() and Erase() fails until PowerOn(). */
+    void CutPowerAfter(uint64_t bytes);
+
+    /** Simulates a reset during the next Erase(): only length bytes from
+     *  offset into the sector are erased, the rest keeps its old contents,
+     *  then power is cut as above. */
+    void CutPowerInErase(uint32_t offset, uint32_t length);
+    void PowerOn(void);
+
+    uint64_t ReadBytes(void) const { return _readBytes; }
+    uint64_t ProgrammedBytes(void) const { return _programmedBytes; }
+    uint64_t ErasedBytes(void) const { return _erasedBytes; }
+    uint32_t SectorErases(uint32_t sector) const { return _erases[sector]; }
+    void ResetCounters(void);
+
+  private:
+    bool InRange(uint32_t addr, uint32_t size) const;
+    void Flush(uint32_t offset, uint32_t size);
+
+    FILE *_file;
+    uint32_t _base;
+    uint32_t _sectorSize;
+    std::vector<uint8_t> _image;
+    std::vector<uint32_t> _erases;
+    uint64_t _readBytes;
+    uint64_t _programmedBytes;
+    uint64_t _erasedBytes;
+    bool _powerCut;
+    uint64_t _budget;               // bytes left before the power cut
+    bool _eraseCut;                 // the next erase is interrupted
+    uint32_t _eraseCutOffset;
+    uint32_t _eraseCutLength;
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*****************************************************************************
+File name: HostMbed.cpp
+Description: Minimal host stand-in for the parts of mbed used by the driver
+             and the portable modules, so they build and run on Linux
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "mbed.h"
+#include "MockLIS3DSH.h"
+#include "USBSerial.h"
+#include <stdarg.h>
+#include <unistd.h>
+#include <vector>
+
+static uint64_t nowNs = 0;
+
+uint64_t host_time_ns(void) {
+    return nowNs;
+}
+
+void host_advance_ns(uint64_t ns) {
+    nowNs += ns;
+}
+
+uint32_t us_ticker_read(void) {
+    return (uint32_t)(nowNs / 1000);
+}
+
+const ticker_data_t *get_us_ticker_data(void) {
+    return NULL;
+}
+
+us_timestamp_t ticker_read_us(const ticker_data_t *ticker) {
+    (void)ticker;
+    return nowNs / 1000;
+}
+
+void wait_us(int us) {
+    host_advance_ns((uint64_t)us * 1000);
+}
+
+void wait_ms(int ms) {
+    host_advance_ns((uint64_t)ms * 1000000);
+}
+
+void thread_sleep_for(uint32_t ms) {
+    host_advance_ns((uint64_t)ms * 1000000);
+}
+
+SPI::SPI(PinName mosi, PinName miso, PinName sclk) : _hz(1000000) {
+    (void)mosi;
+    (void)miso;
+    (void)sclk;
+}
+
+void SPI::format(int bits, int mode) {
+    (void)bits;
+    (void)mode;
+}
+
+void SPI::frequency(int hz) {
+    _hz = hz;
+}
+
+int SPI::write(int value) {
+    /* one byte on the bus takes 8 clock periods */
+    host_advance_ns(8000000000ULL / _hz);
+    if (MockLIS3DSH::attached == NULL) {
+        return 0xFF;
+    }
+    return MockLIS3DSH::attached->Transfer((uint8_t)value);
+}
+
+DigitalOut::DigitalOut(PinName pin, int value) : _pin(pin), _value(value) {
+}
+
+void DigitalOut::write(int value) {
+    _value = value;
+    MockLIS3DSH *device = MockLIS3DSH::attached;
+    if (device != NULL && _pin == device->CsPin()) {
+        device->Select(value == 0);
+    }
+}
+
+static int inputs[BUTTON1 + 1];
+
+void host_set_input(PinName pin, int value) {
+    if (pin >= 0 && pin <= BUTTON1) {
+        inputs[pin] = value;
+    }
+}
+
+DigitalIn::DigitalIn(PinName pin) : _pin(pin) {
+}
+
+int DigitalIn::read(void) {
+    return (_pin >= 0 && _pin <= BUTTON1) ? inputs[_pin] : 0;
+}
+
+static const uint32_t FLASH_BASE = 0x08000000;
+static const uint32_t FLASH_SIZE = 0x100000;
+static std::vector<uint8_t> flashImage;
+
+/* false when addr / size leave the flash */
+static bool flashRange(uint32_t addr, uint32_t size) {
+    return addr >= FLASH_BASE && size <= FLASH_SIZE && addr - FLASH_BASE <= FLASH_SIZE - size;
+}
+
+int FlashIAP::init(void) {
+    if (flashImage.empty()) {
+        flashImage.assign(FLASH_SIZE, 0xFF);
+    }
+    return 0;
+}
+
+int FlashIAP::read(void *buffer, uint32_t addr, uint32_t size) {
+    if (!flashRange(addr, size)) {
+        return -1;
+    }
+    memcpy(buffer, &flashImage[addr - FLASH_BASE], size);
+    return 0;
+}
+
+int FlashIAP::program(const void *buffer, uint32_t addr, uint32_t size) {
+    if (!flashRange(addr, size)) {
+        return -1;
+    }
+    /* programming only clears bits */
+    const uint8_t *src = (const uint8_t *)buffer;
+    for (uint32_t i = 0; i < size; i++) {
+        flashImage[addr - FLASH_BASE + i] &= src[i];
+    }
+    return 0;
+}
+
+int FlashIAP::erase(uint32_t addr, uint32_t size) {
+    if (!flashRange(addr, size)) {
+        return -1;
+    }
+    memset(&flashImage[addr - FLASH_BASE], 0xFF, size);
+    return 0;
+}
+
+USBSerial::USBSerial(uint16_t vendorId, uint16_t productId, uint16_t productRelease, bool connectBlocking) {
+    (void)vendorId;
+    (void)productId;
+    (void)productRelease;
+    (void)connectBlocking;
+}
+
+int USBSerial::printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+int USBSerial::putc(int c) {
+    return putchar(c);
+}
+
+int USBSerial::getc(void) {
+    return getchar();
+}
+
+int USBSerial::readable(void) {
+    return 0;
+}
+
+bool USBSerial::send(uint8_t *buffer, uint32_t size) {
+    return fwrite(buffer, 1, size, stdout) == size;
+}
+
+ssize_t USBSerial::write(const void *buffer, size_t size) {
+    return (ssize_t)fwrite(buffer, 1, size, stdout);
+}
+
+ssize_t USBSerial::read(void *buffer, size_t size) {
+    return ::read(0, buffer, size);
+}
@@ -0,0 +1,251 @@
+/*****************************************************************************
+File name: MockLIS3DSH.cpp
+Description: Register level model of the LIS3DSH behind the host SPI, used
+             by the benchmarks and simulators
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "MockLIS3DSH.h"
+#include <string.h>
+
+#define REG_INFO1       0x0D
+#define REG_WHO_AM_I    0x0F
+#define REG_OFF_X       0x10
+#define REG_CTRL_REG4   0x20
+#define REG_CTRL_REG3   0x23
+#define REG_CTRL_REG6   0x25
+#define REG_STATUS      0x27
+#define REG_OUT_X_L     0x28
+#define REG_OUT_Z_H     0x2D
+#define REG_FIFO_CTRL   0x2E
+#define REG_FIFO_SRC    0x2F
+
+#define STATUS_ZYXDA    0x08
+#define STATUS_ZYXOR    0x80
+#define CTRL3_STRT      0x01
+#define CTRL6_BOOT      0x80
+#define CTRL6_FIFO_EN   0x40
+#define CTRL6_ADD_INC   0x10
+#define FIFO_MODE_SHIFT 5
+#define FIFO_SRC_OVRN   0x40
+#define FIFO_SRC_EMPTY  0x20
+
+/* power up, reboot and soft reset: registers read 0 and the bit stays set for this long */
+#define BOOT_TIME_US    5000
+
+/* CTRL_REG4 ODR field to period in microseconds, 0 is power down */
+static const uint32_t ODR_PERIOD_US[16] = {
+    0, 320000, 160000, 80000, 40000, 20000, 10000, 2500, 1250, 625,
+    625, 625, 625, 625, 625, 625
+};
+
+MockLIS3DSH *MockLIS3DSH::attached = NULL;
+
+MockLIS3DSH::MockLIS3DSH()
+: _cs(NC), _selected(false), _first(false), _read(false), _addr(0),
+  _source(NULL), _ctx(NULL), _lastLatchUs(0), _fault(FAULT_NONE), _faultStartUs(0), _faultDurationUs(0)
+{
+    memset(_raw, 0, sizeof(_raw));
+    ResetRegs();
+    StartBoot(0);           // powered up now
+}
+
+void MockLIS3DSH::ResetRegs(void) {
+    memset(_regs, 0, sizeof(_regs));
+    _fifoHead = 0;
+    _fifoCount = 0;
+    _fifoOverrun = false;
+    _regs[REG_INFO1] = 0x21;
+    _regs[REG_WHO_AM_I] = 0x3F;
+    _regs[REG_CTRL_REG4] = 0x07;
+    _regs[REG_CTRL_REG6] = CTRL6_ADD_INC;
+}
+
+void MockLIS3DSH::InjectFault(Fault fault, uint32_t durationUs) {
+    _fault = fault;
+    _faultStartUs = us_ticker_read();
+    _faultDurationUs = durationUs;
+}
+
+MockLIS3DSH::Fault MockLIS3DSH::ActiveFault(void) {
+    if (_fault != FAULT_NONE && _faultDurationUs != 0 && us_ticker_read() - _faultStartUs >= _faultDurationUs) {
+        _fault = FAULT_NONE;
+    }
+    return _fault;
+}
+
+void MockLIS3DSH::StartBoot(uint8_t busyReg) {
+    if (ActiveFault() != FAULT_BUS) {
+        _fault = FAULT_NONE;        // the reset brings the part back
+    }
+    _booting = true;
+    _busyReg = busyReg;
+    _bootStartUs = us_ticker_read();
+}
+
+void MockLIS3DSH::Attach(PinName cs) {
+    _cs = cs;
+    attached = this;
+}
+
+void MockLIS3DSH::SetSource(Source source, void *ctx) {
+    _source = source;
+    _ctx = ctx;
+    _lastLatchUs = us_ticker_read();
+}
+
+void MockLIS3DSH::SetSample(int16_t x, int16_t y, int16_t z) {
+    int16_t xyz[3] = {x, y, z};
+
+    _raw[0] = x;
+    _raw[1] = y;
+    _raw[2] = z;
+    for (int i = 0; i < 3; i++) {
+        /* OFF_x is subtracted in steps of 32 counts, the output saturates */
+        int32_t value = xyz[i] - 32 * (int8_t)_regs[REG_OFF_X + i];
+        xyz[i] = (int16_t)(value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : value));
+    }
+    if (FifoEnabled()) {
+        /* stream mode, a full FIFO drops its oldest sample */
+        if (_fifoCount == FIFO_DEPTH) {
+            _fifoHead = (_fifoHead + 1) % FIFO_DEPTH;
+            _fifoCount--;
+            _fifoOverrun = true;
+        }
+        memcpy(_fifo[(_fifoHead + _fifoCount) % FIFO_DEPTH], xyz, sizeof(xyz));
+        _fifoCount++;
+        LoadOutput(_fifo[_fifoHead]);
+        return;
+    }
+    LoadOutput(xyz);
+    if (_regs[REG_STATUS] & STATUS_ZYXDA) {
+        _regs[REG_STATUS] |= STATUS_ZYXOR;      // previous sample never read
+    }
+    _regs[REG_STATUS] |= STATUS_ZYXDA;
+}
+
+void MockLIS3DSH::LoadOutput(const int16_t xyz[3]) {
+    for (int i = 0; i < 3; i++) {
+        _regs[REG_OUT_X_L + 2*i] = (uint8_t)(xyz[i] & 0xFF);
+        _regs[REG_OUT_X_L + 2*i + 1] = (uint8_t)((uint16_t)xyz[i] >> 8);
+    }
+}
+
+bool MockLIS3DSH::FifoEnabled(void) const {
+    return (_regs[REG_CTRL_REG6] & CTRL6_FIFO_EN) && (_regs[REG_FIFO_CTRL] >> FIFO_MODE_SHIFT) != 0;
+}
+
+/* the output registers show the oldest unread sample, reading OUT_Z_H moves on */
+void MockLIS3DSH::FifoPop(void) {
+    if (_fifoCount == 0) {
+        return;
+    }
+    _fifoHead = (_fifoHead + 1) % FIFO_DEPTH;
+    _fifoCount--;
+    _fifoOverrun = false;
+    if (_fifoCount > 0) {
+        LoadOutput(_fifo[_fifoHead]);
+    }
+}
+
+uint32_t MockLIS3DSH::OdrPeriodUs(void) const {
+    return ODR_PERIOD_US[_regs[REG_CTRL_REG4] >> 4];
+}
+
+void MockLIS3DSH::Update(void) {
+    uint32_t period = OdrPeriodUs();
+    uint32_t now = us_ticker_read();
+
+    if (_booting) {
+        if (now - _bootStartUs < BOOT_TIME_US) {
+            _lastLatchUs = now;
+            return;
+        }
+        _booting = false;
+        if (_busyReg == REG_CTRL_REG3) {
+            _regs[REG_CTRL_REG3] &= ~CTRL3_STRT;
+        } else if (_busyReg == REG_CTRL_REG6) {
+            _regs[REG_CTRL_REG6] &= ~CTRL6_BOOT;
+        }
+        _lastLatchUs = now;
+    }
+    Fault fault = ActiveFault();
+    if (period == 0 || fault == FAULT_STALL) {
+        _lastLatchUs = now;
+        return;
+    }
+    /* one conversion per elapsed period, only the newest one stays readable */
+    while (now - _lastLatchUs >= period) {
+        if (fault == FAULT_FROZEN) {
+            _regs[REG_STATUS] |= STATUS_ZYXDA;
+            _lastLatchUs += period;
+            continue;
+        }
+        int16_t xyz[3] = {_raw[0], _raw[1], _raw[2]};
+        if (_source != NULL) {
+            _source(xyz, _ctx);
+        }
+        SetSample(xyz[0], xyz[1], xyz[2]);
+        _lastLatchUs += period;
+    }
+}
+
+void MockLIS3DSH::Select(bool selected) {
+    _selected = selected;
+    _first = selected;
+    if (selected) {
+        Update();
+    }
+}
+
+uint8_t MockLIS3DSH::Transfer(uint8_t out) {
+    if (!_selected || ActiveFault() == FAULT_BUS) {
+        return 0xFF;
+    }
+    if (_first) {
+        _first = false;
+        _read = (out & 0x80) != 0;
+        _addr = out & 0x7F;
+        return 0x00;
+    }
+
+    uint8_t in = 0x00;
+    if (_booting) {
+        /* only the bit of the running reset reads back */
+        in = (_read && _addr == _busyReg) ? _regs[_addr] : 0x00;
+    } else if (_read) {
+        in = _regs[_addr];
+        if (_addr == REG_WHO_AM_I && _fault == FAULT_IDENTITY) {
+            in ^= 0x01;
+        }
+        if (_addr == REG_STATUS && FifoEnabled()) {
+            in = _fifoCount > 0 ? STATUS_ZYXDA : 0x00;
+        } else if (_addr == REG_FIFO_SRC) {
+            in = (uint8_t)((_fifoOverrun ? FIFO_SRC_OVRN : 0) | (_fifoCount == 0 ? FIFO_SRC_EMPTY : 0) | (_fifoCount & 0x1F));
+        }
+        if (_addr == REG_OUT_Z_H && FifoEnabled()) {
+            FifoPop();
+        } else if (_addr == REG_OUT_Z_H) {
+            _regs[REG_STATUS] &= ~(STATUS_ZYXDA | STATUS_ZYXOR);
+        }
+    } else if (_addr == REG_CTRL_REG3 && (out & CTRL3_STRT)) {
+        ResetRegs();
+        _regs[REG_CTRL_REG3] = CTRL3_STRT;
+        StartBoot(REG_CTRL_REG3);
+    } else if (_addr == REG_CTRL_REG6 && (out & CTRL6_BOOT)) {
+        _regs[REG_CTRL_REG6] = out;
+        StartBoot(REG_CTRL_REG6);
+    } else if (_addr != REG_WHO_AM_I && _addr != REG_STATUS) {
+        _regs[_addr] = out;
+    }
+    if (_regs[REG_CTRL_REG6] & CTRL6_ADD_INC) {
+        /* with the FIFO on a burst wraps from OUT_Z_H back to OUT_X_L */
+        _addr = (_addr == REG_OUT_Z_H && FifoEnabled()) ? REG_OUT_X_L : ((_addr + 1) & 0x7F);
+    }
+    if (!FifoEnabled()) {
+        _fifoCount = 0;                         // bypass mode empties the FIFO
+        _fifoOverrun = false;
+    }
+    return in;
+}
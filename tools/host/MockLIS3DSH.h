@@ -0,0 +1,101 @@
+/*****************************************************************************
+File name: MockLIS3DSH.h
+Description: Register level model of the LIS3DSH behind the host SPI, used
+             by the benchmarks and simulators
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef MOCKLIS3DSH_H
+#define MOCKLIS3DSH_H
+
+#include "mbed.h"
+
+/** Simulated LIS3DSH. Answers SPI register reads and writes, and latches a
+ *  new sample from the source on every output data rate period of the
+ *  simulated clock. After power up, a soft reset (CTRL_REG3 STRT) or a
+ *  reboot (CTRL_REG6 BOOT) the part is busy for a few milliseconds:
+ *  registers read 0 and only the reset bit reads back until it clears.
+ *  With CTRL_REG6 FIFO_EN and a FIFO mode set, samples queue in a 32 deep
+ *  FIFO (stream mode semantics) reported by FIFO_SRC.
+ */
+class MockLIS3DSH {
+  public:
+    static const uint8_t FIFO_DEPTH = 32;
+
+    /** Faults for InjectFault(). */
+    enum Fault {
+        FAULT_NONE = 0,
+        FAULT_STALL,            // conversions stop, ZYXDA stays clear (the sampling lock-up)
+        FAULT_FROZEN,           // ZYXDA keeps being set, the output registers stop changing
+        FAULT_IDENTITY,         // WHO_AM_I reads a wrong value
+        FAULT_BUS               // MISO stuck high, every byte reads 0xFF and writes are lost
+    };
+
+    /** Produces the next raw sample, ctx is the pointer given to SetSource(). */
+    typedef void (*Source)(int16_t xyz[3], void *ctx);
+
+    MockLIS3DSH();
+
+    /** Routes SPI transfers to this device while cs is low. */
+    void Attach(PinName cs);
+
+    /** Sets the function producing samples, NULL keeps converting the last sample. */
+    void SetSource(Source source, void *ctx);
+
+    /** Latches a sample immediately, as if a conversion just finished.
+     *  The OFF_X/Y/Z corrections are applied like on the part. */
+    void SetSample(int16_t x, int16_t y, int16_t z);
+
+    /** Starts a fault. A soft reset or reboot clears the sensor faults, the
+     *  bus fault only ends with its duration.
+     * @param
+     *     fault one of Fault, FAULT_NONE ends the current one
+     *     durationUs simulated time after which the fault ends, 0 = never
+     */
+    void InjectFault(Fault fault, uint32_t durationUs = 0);
+
+    /** Fault in effect now. */
+    Fault ActiveFault(void);
+
+    /** Register contents, for inspection. */
+    uint8_t Reg(uint8_t addr) const { return _regs[addr & 0x7F]; }
+
+    /* used by the host SPI and DigitalOut */
+    static MockLIS3DSH *attached;
+    void Select(bool selected);
+    uint8_t Transfer(uint8_t out);
+    PinName CsPin(void) const { return _cs; }
+
+  private:
+    void Update(void);
+    void ResetRegs(void);
+    void StartBoot(uint8_t busyReg);
+    void LoadOutput(const int16_t xyz[3]);
+    bool FifoEnabled(void) const;
+    void FifoPop(void);
+    uint32_t OdrPeriodUs(void) const;
+
+    uint8_t _regs[128];
+    PinName _cs;
+    bool _selected;
+    bool _first;
+    bool _read;
+    uint8_t _addr;
+    Source _source;
+    void *_ctx;
+    uint32_t _lastLatchUs;
+    int16_t _raw[3];            // last sample before the offsets
+    bool _booting;
+    uint8_t _busyReg;           // register whose reset bit is pending, 0 at power up
+    uint32_t _bootStartUs;
+    int16_t _fifo[FIFO_DEPTH][3];
+    uint8_t _fifoHead;          // oldest unread sample
+    uint8_t _fifoCount;
+    bool _fifoOverrun;
+    Fault _fault;
+    uint32_t _faultStartUs;
+    uint32_t _faultDurationUs;
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*****************************************************************************
+File name: TraceFile.cpp
+Description: Reader for recorded accelerometer traces (see
+             tools/train_classifier.py for the format)
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#include "TraceFile.h"
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static std::string trim(const char *begin, const char *end) {
+    while (begin < end && isspace((unsigned char)*begin)) begin++;
+    while (end > begin && isspace((unsigned char)end[-1])) end--;
+    return std::string(begin, end);
+}
+
+/* strtol() bounded by end, the text need not be NUL terminated (e.g. a
+   mapped file ending in a digit), *next is p when there is no number */
+static long parseLong(const char *p, const char *end, const char **next) {
+    const char *q = p;
+    bool negative = false;
+    long v = 0;
+
+    while (q < end && (*q == ' ' || *q == '\t')) q++;
+    if (q < end && (*q == '-' || *q == '+')) {
+        negative = (*q == '-');
+        q++;
+    }
+    const char *digits = q;
+    while (q < end && isdigit((unsigned char)*q)) {
+        if (v <= (LONG_MAX - 9) / 10) {
+            v = v * 10 + (*q - '0');
+        }
+        q++;
+    }
+    *next = (q == digits) ? p : q;
+    return negative ? -v : v;
+}
+
+/* between the numbers of a sample line, '\r' ends a CRLF line */
+static bool isSeparator(char c) {
+    return c == ',' || c == ' ' || c == '\t' || c == '\r';
+}
+
+static std::string directoryName(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return "";
+    }
+    size_t start = path.find_last_of('/', slash - 1);
+    start = (start == std::string::npos) ? 0 : start + 1;
+    return path.substr(start, slash - start);
+}
+
+bool parseTrace(const char *text, size_t length, const std::string &path, Trace *trace) {
+    const char *p = text;
+    const char *end = text + length;
+
+    trace->label.clear();
+    trace->reps = -1;
+    trace->timestamps.clear();
+    trace->xyz.clear();
+
+    while (p < end) {
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        if (eol == NULL) {
+            eol = end;
+        }
+        while (p < eol && (*p == ' ' || *p == '\t')) p++;
+        if (p < eol && *p == '#') {
+            const char *colon = (const char *)memchr(p, ':', eol - p);
+            if (colon != NULL) {
+                std::string key = trim(p + 1, colon);
+                std::string value = trim(colon + 1, eol);
+                if (key == "label") {
+                    trace->label = value;
+                } else if (key == "reps") {
+                    trace->reps = atoi(value.c_str());
+                }
+            }
+        } else if (p < eol && (isdigit((unsigned char)*p) || *p == '-' || *p == '+')) {
+            /* t_us,x,y,z or x,y,z, a line with anything else is skipped
+               like in load_trace() of tools/train_classifier.py */
+            long v[4];
+            int n = 0;
+            bool valid = true;
+            const char *q = p;
+            while (q < eol) {
+                const char *next;
+                long value = parseLong(q, eol, &next);
+                if (next == q || n == 4) {
+                    valid = false;
+                    break;
+                }
+                v[n++] = value;
+                q = next;
+                while (q < eol && isSeparator(*q)) q++;
+            }
+            if (valid && n >= 3) {
+                trace->timestamps.push_back(n == 4 ? (uint32_t)v[0] : (uint32_t)(trace->Samples() * 100000));
+                trace->xyz.push_back((int16_t)v[n - 3]);
+                trace->xyz.push_back((int16_t)v[n - 2]);
+                trace->xyz.push_back((int16_t)v[n - 1]);
+            }
+        }
+        p = eol + 1;
+    }
+    for (size_t i = 0; i < trace->label.size(); i++) {
+        trace->label[i] = (char)tolower((unsigned char)trace->label[i]);
+    }
+    if (trace->label.empty()) {
+        trace->label = directoryName(path);
+    }
+    return !trace->xyz.empty();
+}
+
+bool loadTrace(const std::string &path, Trace *trace) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    std::string text;
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        text.append(buffer, n);
+    }
+    fclose(f);
+    return parseTrace(text.data(), text.size(), path, trace);
+}
+
+Trace syntheticTrace(size_t samples, int periodSamples, uint32_t seed) {
+    Trace trace;
+    const double PI = 3.14159265358979;
+    uint32_t state = seed ? seed : 1;
+
+    trace.label = "synthetic";
+    trace.reps = (int)(samples / periodSamples);
+    for (size_t i = 0; i < samples; i++) {
+        /* xorshift noise of +/- 128 counts */
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int noise = (int)(state & 0xFF) - 128;
+        double phase = 2 * PI * (double)i / periodSamples;
+        trace.timestamps.push_back((uint32_t)(i * 100000));
+        trace.xyz.push_back((int16_t)(1500 + noise));
+        trace.xyz.push_back((int16_t)(9000 * sin(phase) + noise));
+        trace.xyz.push_back((int16_t)(-14000 + 3000 * cos(phase) - noise));
+    }
+    return trace;
+}
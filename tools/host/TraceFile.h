@@ -0,0 +1,56 @@
+/*****************************************************************************
+File name: TraceFile.h
+Description: Reader for recorded accelerometer traces (see
+             tools/train_classifier.py for the format)
+Author: Junyu Bian
+Date: 10/18/2026
+*****************************************************************************/
+
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** One recorded session, raw LIS3DSH::ReadData() values. */
+struct Trace {
+    std::string label;                  // "# label:" header, else parent directory
+    int reps;                           // "# reps:" header, -1 when missing
+    std::vector<uint32_t> timestamps;   // t_us column, microseconds
+    std::vector<int16_t> xyz;           // interleaved x, y, z
+
+    size_t Samples(void) const { return xyz.size() / 3; }
+};
+
+/** Parses a trace from memory.
+* @param
+*     text file contents
+*     length number of bytes
+*     path file name, used for the default label
+*     trace output
+* @return
+*     true on success, false when no sample line was found.
+*/
+bool parseTrace(const char *text, size_t length, const std::string &path, Trace *trace);
+
+/** Reads and parses a trace file.
+* @param
+*     path file name
+*     trace output
+* @return
+*     true on success.
+*/
+bool loadTrace(const std::string &path, Trace *trace);
+
+/** Builds a synthetic trace, a sine swing on y and z around a fixed posture.
+* @param
+*     samples number of samples
+*     periodSamples samples per repetition
+*     seed noise seed
+* @return
+*     The trace, labelled "synthetic".
+*/
+Trace syntheticTrace(size_t samples, int periodSamples, uint32_t seed);
+
+#endif
@@ -0,0 +1,39 @@
+/*****************************************************************************
+File name: USBSerial.h
+Description: Host stand-in for mbed's USBSerial, output goes to stdout
+Author: Junyu Bian
+Date: 10/18/2026
+
+Keeps the access of the mbed classes: printf(), putc(), getc() of Stream and
+send() of USBCDC are public, the FileHandle write() and read() are
+protected in Stream, so a call that would not build for the board does not
+build here either.
+*****************************************************************************/
+
+#ifndef HOST_USBSERIAL_H
+#define HOST_USBSERIAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+class USBSerial {
+  public:
+    USBSerial(uint16_t vendorId = 0x1f00, uint16_t productId = 0x2012,
+              uint16_t productRelease = 0x0001, bool connectBlocking = true);
+
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    int putc(int c);
+    int getc(void);
+    int readable(void);
+    bool connected(void) { return true; }
+
+    /* USBCDC, blocks until all bytes are sent */
+    bool send(uint8_t *buffer, uint32_t size);
+
+  protected:
+    ssize_t write(const void *buffer, size_t size);
+    ssize_t read(void *buffer, size_t size);
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*****************************************************************************
+File name: mbed.h
+Description: Minimal host stand-in for the parts of mbed used by the driver
+             and the portable modules, so they build and run on Linux
+Author: Junyu Bian
+Date: 10/18/2026
+
+SPI transfers go to the MockLIS3DSH attached with MockLIS3DSH::Attach(),
+time is a simulated microsecond clock advanced by waits and SPI transfers.
+*****************************************************************************/
+
+#ifndef HOST_MBED_H
+#define HOST_MBED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+#define DEVICE_FLASH 1
+
+typedef int PinName;
+
+enum {
+    PA_5, PA_6, PA_7, PE_3,
+    SPI_MOSI, SPI_MISO, SPI_SCK,
+    LED3, LED4, LED5, LED6, BUTTON1,
+    NC = -1
+};
+
+class SPI {
+  public:
+    SPI(PinName mosi, PinName miso, PinName sclk);
+    void format(int bits, int mode = 0);
+    void frequency(int hz = 1000000);
+    int write(int value);
+
+  private:
+    int _hz;
+};
+
+class DigitalOut {
+  public:
+    DigitalOut(PinName pin, int value = 0);
+    void write(int value);
+    int read(void) { return _value; }
+    DigitalOut &operator=(int value) { write(value); return *this; }
+    operator int() { return _value; }
+
+  private:
+    PinName _pin;
+    int _value;
+};
+
+/* reads the level set with host_set_input(), 0 until then */
+class DigitalIn {
+  public:
+    DigitalIn(PinName pin);
+    int read(void);
+    operator int() { return read(); }
+
+  private:
+    PinName _pin;
+};
+
+/* internal flash of the STM32F407, 1 MB at 0x08000000, erased to 0xFF */
+class FlashIAP {
+  public:
+    int init(void);
+    int deinit(void) { return 0; }
+    int read(void *buffer, uint32_t addr, uint32_t size);
+    int program(const void *buffer, uint32_t addr, uint32_t size);
+    int erase(uint32_t addr, uint32_t size);
+};
+
+void wait_us(int us);
+void wait_ms(int ms);
+void thread_sleep_for(uint32_t ms);
+
+/* simulated time since start in microseconds */
+uint32_t us_ticker_read(void);
+
+/* the same in 64 bits, through the ticker API of hal/ticker_api.h */
+typedef uint64_t us_timestamp_t;
+typedef struct ticker_data_s ticker_data_t;
+const ticker_data_t *get_us_ticker_data(void);
+us_timestamp_t ticker_read_us(const ticker_data_t *ticker);
+
+/* simulated time since start in nanoseconds, host only */
+uint64_t host_time_ns(void);
+
+/* advances the simulated clock, host only */
+void host_advance_ns(uint64_t ns);
+
+/* level read by DigitalIn on a pin, host only */
+void host_set_input(PinName pin, int value);
+
+#endif
@@ -0,0 +1,346 @@
+"""
+File name: memory_budget.py
+Description: Static RAM / flash budget report built from the GNU ld map file.
+
+Breaks the image down per subsystem (SUBSYSTEMS below) and fails the build
+when a limit from `custom_memory_limits` in platformio.ini is exceeded.
+Code and constants are attributed by the object or archive they come from.
+RAM is attributed by symbol first, because the instances of most modules
+are globals of src/main.cpp; a .bss / .data symbol that matches no symbol
+pattern falls back to its object:
+
+    custom_memory_limits =
+        total.flash = 524288
+        total.ram = 65536
+        window.ram = 512
+
+With `custom_memory_baseline = file.json` every subsystem is also compared
+with a recorded build (columns "+/-"). Builds only read the file; it is
+written on request, from the build of the commit to compare against:
+
+    pio run -e disco_f407vg -t memory_baseline
+
+or in one step from any checkout, building the given commit in a temporary
+git worktree and attributing its map with the SUBSYSTEMS of this file:
+
+    python3 tools/memory_budget.py --record-from 9c11ab8 \\
+        --baseline tools/memory_baseline.json
+
+Runs as a PlatformIO post script (extra_scripts = post:tools/memory_budget.py)
+or standalone on any map file:
+
+    python3 tools/memory_budget.py .pio/build/disco_f407vg/firmware.map \\
+        --limit total.flash=524288 --baseline before.json [--save-baseline]
+"""
+
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# subsystem name, regular expression on the object / archive path, regular
+# expression on the RAM symbols it owns (e.g. its instances in main.cpp)
+SUBSYSTEMS = [
+    ("driver", r"LIS3DSH", r"acc"),
+    ("classifier", r"Classifier", None),
+    ("window", r"SampleWindow|MovingAverage|StillnessDetector", r"presamples|filter|stillness"),
+    ("pipeline", r"Pipeline", r"acquisition"),
+    ("codec", r"SampleCodec", r"captureBuffer"),
+    ("burst", r"BurstCapture", r"burst|burstQueue\w*|fifoSamples"),
+    ("log", r"SessionLog|FlashIAPDevice", r"sessionLog|flash|logReady"),
+    ("scheduler", r"SampleScheduler", r"scheduler"),
+    ("profiler", r"Profiler", None),
+    ("app", r"[/\\]src[/\\]main\.cpp", None),
+    ("mbed-os", r"mbed|FrameworkMbed|TARGET_|USBDevice|usb", None),
+    ("libc", r"lib(c|g|m|nosys|stdc\+\+|supc\+\+|gcc)(_nano)?\.a|crt", None),
+]
+
+SECTION = re.compile(r"^ (\.\S+|COMMON)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+))?$")
+SECTION_CONT = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+)$")
+OUTPUT = re.compile(r"^(\.\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)(\s+load address)?")
+REGION = re.compile(r"^(\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S+)?")
+SYMBOL = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+([A-Za-z_][^\s=()]*)\s*$")
+RAM_SECTION = re.compile(r"^\.(bss|data|sbss|sdata)(\.|$)|^COMMON$")
+
+
+def subsystem(path):
+    for name, pattern, _ in SUBSYSTEMS:
+        if re.search(pattern, path):
+            return name
+    return "other"
+
+
+def symbol_subsystem(symbol):
+    """Subsystem owning a RAM symbol, None when no symbol pattern matches."""
+    for name, _, pattern in SUBSYSTEMS:
+        if pattern and re.fullmatch(pattern, symbol):
+            return name
+    return None
+
+
+def parse_map(path):
+    """Returns {subsystem: {"flash": bytes, "ram": bytes}}."""
+    regions = []
+    usage = {}
+    output_loaded = False       # current output section also has a flash load image
+    in_regions = in_map = False
+    pending = None
+    current = None              # input section, symbol lines may still follow
+
+    with open(path) as f:
+        lines = f.read().splitlines()
+
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            in_regions = True
+            continue
+        if line.startswith("Linker script and memory map"):
+            in_regions, in_map = False, True
+            continue
+        if in_regions:
+            m = REGION.match(line)
+            if m and m.group(1) not in ("Name", "*default*"):
+                attrs = m.group(4) or ""
+                regions.append((int(m.group(2), 16), int(m.group(3), 16), "w" in attrs))
+            continue
+        if not in_map:
+            continue
+
+        m = OUTPUT.match(line)
+        if m:
+            account(usage, regions, current)
+            current = None
+            output_loaded = bool(m.group(4)) or m.group(1).startswith(".data")
+            pending = None
+            continue
+
+        if pending is not None:
+            m = SECTION_CONT.match(line)
+            if m:
+                account(usage, regions, current)
+                current = {"section": pending, "address": int(m.group(1), 16),
+                           "size": int(m.group(2), 16), "source": m.group(3).strip(),
+                           "loaded": output_loaded, "symbols": []}
+            pending = None
+            continue
+
+        m = SYMBOL.match(line)
+        if m and current is not None:
+            current["symbols"].append((int(m.group(1), 16), m.group(2)))
+            continue
+
+        m = SECTION.match(line)
+        if not m:
+            continue
+        account(usage, regions, current)
+        current = None
+        if m.group(2) is None:
+            pending = m.group(1)        # address, size and file on the next line
+            continue
+        current = {"section": m.group(1), "address": int(m.group(2), 16),
+                   "size": int(m.group(3), 16), "source": m.group(4).strip(),
+                   "loaded": output_loaded, "symbols": []}
+    account(usage, regions, current)
+    return usage
+
+
+def add(usage, name, writable, loaded, size):
+    entry = usage.setdefault(name, {"flash": 0, "ram": 0})
+    if writable:
+        entry["ram"] += size
+        if loaded:
+            entry["flash"] += size      # initial values of .data
+    else:
+        entry["flash"] += size
+
+
+def ram_symbols(section):
+    """(address, name) of the symbols in a RAM input section. Only global
+    symbols get a line in the map, a static one is named by its section
+    when built with -fdata-sections (.bss.<name>)."""
+    start, end = section["address"], section["address"] + section["size"]
+    symbols = sorted(s for s in section["symbols"] if start <= s[0] < end)
+    if not symbols:
+        parts = section["section"].split(".", 2)
+        if len(parts) == 3 and parts[2]:
+            symbols = [(start, parts[2])]
+    return symbols
+
+
+def account(usage, regions, section):
+    if section is None:
+        return
+    address, size = section["address"], section["size"]
+    if size == 0 or address == 0:
+        return                          # discarded or debug only
+    writable = None
+    for origin, length, w in regions:
+        if origin <= address < origin + length:
+            writable = w
+            break
+    if writable is None:
+        if regions:
+            return                      # not in a target memory region
+        writable = bool(RAM_SECTION.match(section["section"]))
+    owner = subsystem(section["source"])
+    loaded = section["loaded"]
+    if not writable:
+        add(usage, owner, False, loaded, size)
+        return
+
+    # each symbol up to the next one, the padding before the first stays with the object
+    end = address + size
+    symbols = ram_symbols(section)
+    if symbols and symbols[0][0] > address:
+        add(usage, owner, True, loaded, symbols[0][0] - address)
+    elif not symbols:
+        add(usage, owner, True, loaded, size)
+    for i, (at, name) in enumerate(symbols):
+        until = symbols[i + 1][0] if i + 1 < len(symbols) else end
+        add(usage, symbol_subsystem(name) or owner, True, loaded, until - at)
+
+
+def parse_limits(text):
+    limits = {}
+    for item in re.split(r"[\n,]", text or ""):
+        if not item.strip():
+            continue
+        key, _, value = item.partition("=")
+        limits[key.strip()] = int(value.strip(), 0)
+    return limits
+
+
+def with_total(usage):
+    rows = dict(usage)
+    rows["total"] = {"flash": sum(u["flash"] for u in usage.values()),
+                     "ram": sum(u["ram"] for u in usage.values())}
+    return rows
+
+
+def report(usage, limits, baseline=None, out=sys.stdout):
+    """Prints the table, returns the list of exceeded limits."""
+    rows = sorted(usage.items(), key=lambda kv: -(kv[1]["flash"] + kv[1]["ram"]))
+    rows.append(("total", with_total(usage)["total"]))
+
+    exceeded = []
+    out.write("Memory budget\n")
+    if baseline is None:
+        out.write("%-12s %10s %10s\n" % ("subsystem", "flash", "ram"))
+    else:
+        out.write("%-12s %10s %8s %10s %8s\n" % ("subsystem", "flash", "+/-", "ram", "+/-"))
+    for name, u in rows:
+        marks = []
+        for kind in ("flash", "ram"):
+            limit = limits.get("%s.%s" % (name, kind))
+            if limit is not None and u[kind] > limit:
+                marks.append("%s > %d" % (kind, limit))
+                exceeded.append("%s.%s = %d > %d" % (name, kind, u[kind], limit))
+        if baseline is None:
+            out.write("%-12s %10d %10d  %s\n" % (name, u["flash"], u["ram"], ", ".join(marks)))
+        else:
+            before = baseline.get(name, {"flash": 0, "ram": 0})
+            out.write("%-12s %10d %+8d %10d %+8d  %s\n" % (
+                name, u["flash"], u["flash"] - before["flash"],
+                u["ram"], u["ram"] - before["ram"], ", ".join(marks)))
+    return exceeded
+
+
+def load_baseline(path):
+    if not path or not os.path.isfile(path):
+        return None
+    with open(path) as f:
+        return json.load(f)
+
+
+def save_baseline(usage, path):
+    with open(path, "w") as f:
+        json.dump(with_total(usage), f, indent=2, sort_keys=True)
+        f.write("\n")
+
+
+def run(map_path, limits, baseline_path=None, save=False):
+    if not os.path.isfile(map_path):
+        sys.stderr.write("memory budget: no map file at %s\n" % map_path)
+        return 1
+    usage = parse_map(map_path)
+    baseline = None if save else load_baseline(baseline_path)
+    exceeded = report(usage, limits, baseline)
+    if save and baseline_path:
+        save_baseline(usage, baseline_path)
+        sys.stdout.write("memory budget: recorded baseline %s\n" % baseline_path)
+    elif baseline_path and baseline is None:
+        sys.stdout.write("memory budget: no baseline at %s, record one with "
+                         "`pio run -t memory_baseline` or --save-baseline\n" % baseline_path)
+    for e in exceeded:
+        sys.stderr.write("memory budget exceeded: %s\n" % e)
+    return 1 if exceeded else 0
+
+
+def record_from(rev, baseline_path, limits, env_name="disco_f407vg"):
+    """Builds rev in a temporary worktree and records its map as the baseline."""
+    root = subprocess.check_output(["git", "rev-parse", "--show-toplevel"]).decode().strip()
+    tmp = tempfile.mkdtemp(prefix="memory_baseline_")
+    worktree = os.path.join(tmp, "tree")
+    subprocess.check_call(["git", "-C", root, "worktree", "add", "--detach", worktree, rev])
+    try:
+        # a build over its own limits still leaves the map behind
+        try:
+            subprocess.call(["pio", "run", "-d", worktree, "-e", env_name])
+        except OSError as e:
+            sys.stderr.write("memory budget: cannot run pio: %s\n" % e)
+            return 1
+        map_path = os.path.join(worktree, ".pio", "build", env_name, "firmware.map")
+        return run(map_path, limits, baseline_path, save=True)
+    finally:
+        subprocess.call(["git", "-C", root, "worktree", "remove", "--force", worktree])
+        shutil.rmtree(tmp, ignore_errors=True)
+
+
+try:
+    Import("env")       # noqa: F821, provided by PlatformIO / SCons
+except NameError:
+    env = None
+
+if env is not None:
+    map_path = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+    limits = parse_limits(env.GetProjectOption("custom_memory_limits", ""))
+    baseline_path = env.GetProjectOption("custom_memory_baseline", "")
+    if baseline_path:
+        baseline_path = os.path.join(env.subst("$PROJECT_DIR"), baseline_path)
+
+    def memory_budget(source, target, env):
+        return run(map_path, limits, baseline_path)
+
+    def memory_baseline(source, target, env):
+        if not baseline_path:
+            sys.stderr.write("memory budget: custom_memory_baseline is not set\n")
+            return 1
+        return run(map_path, limits, baseline_path, save=True)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", memory_budget)
+    env.AddCustomTarget("memory_baseline", "$BUILD_DIR/${PROGNAME}.elf", memory_baseline,
+                        title="Memory baseline", description="Records the memory budget baseline")
+
+elif __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser(description="Static RAM / flash budget report")
+    parser.add_argument("map", nargs="?")
+    parser.add_argument("--limit", action="append", default=[],
+                        help="subsystem.flash|ram=bytes, may be repeated")
+    parser.add_argument("--baseline", help="JSON of a previous build to compare with")
+    parser.add_argument("--save-baseline", action="store_true",
+                        help="write this build to --baseline instead of comparing")
+    parser.add_argument("--record-from", metavar="REV",
+                        help="build REV in a temporary worktree and write its map to --baseline")
+    args = parser.parse_args()
+    if args.record_from:
+        if not args.baseline:
+            parser.error("--record-from needs --baseline")
+        sys.exit(record_from(args.record_from, args.baseline, parse_limits(",".join(args.limit))))
+    if not args.map:
+        parser.error("a map file is required")
+    sys.exit(run(args.map, parse_limits(",".join(args.limit)), args.baseline, args.save_baseline))
@@ -0,0 +1,361 @@
+#!/usr/bin/env python3
+"""
+File name: train_classifier.py
+Description: Host side training tool for the on-device exercise classifier.
+
+Learns a small decision tree over int8 quantized window features and emits
+include/ClassifierModel.h, a header of constexpr tables evaluated by
+src/Classifier.cpp with no heap, no floating point and a bounded depth.
+
+Trace files are plain text, one sample per line:
+
+    # label: situps
+    # reps: 5
+    t_us,x,y,z
+    0,-1203,854,16980
+    100000,-1188,861,16991
+    ...
+
+x, y, z are the raw int16 values returned by LIS3DSH::ReadData(), t_us is the
+sample timestamp in microseconds. When the label header is missing the name
+of the parent directory is used instead.
+
+Usage:
+    python3 tools/train_classifier.py traces/ -o include/ClassifierModel.h
+    python3 tools/train_classifier.py --synthetic 400 -o include/ClassifierModel.h
+"""
+
+import argparse
+import math
+import os
+import random
+import re
+import sys
+
+NUMBER = re.compile(r"^[+-]?\d+$")
+CLASSES = ["situps", "pushups", "jumpjacks", "squats", "rest"]
+CLASS_NAMES = ["SitUps", "PushUps", "JumpJacks", "Squats", "Rest"]
+FEATURES = ["meanX", "meanY", "meanZ", "rangeY", "rangeZ"]
+
+# must match include/SampleWindow.h and include/MovingAverage.h
+WINDOW_LENGTH = 20          # SampleWindow::LENGTH
+FILTER_LENGTH = 20          # MovingAverage::LENGTH
+COUNTS_PER_G = 16667        # LIS3DSH::CountsPerG(FS_2G), 0.06 mg/digit
+ANGLE_SCALE = 16            # SampleWindow::ANGLE_SCALE, angle units per degree
+ACOS_STEPS = 256            # ACOS_STEPS in src/SampleWindow.cpp
+
+# hand tuned angle ranges (X, Y, Z) formerly hardcoded in isSU/isJJ/isPU/isS,
+# used as a prior when no recorded traces are available
+HAND_TUNED_RANGES = {
+    "situps":    ((60, 100), (80, 140), (120, 180)),
+    "pushups":   ((80, 100), (60, 90), (20, 40)),
+    "jumpjacks": ((60, 160), (80, 120), (30, 80)),
+    "squats":    ((60, 100), (80, 140), (120, 180)),
+}
+
+
+def quantize(value, lo, hi):
+    """Saturate, identical to saturate() in Classifier.cpp."""
+    return max(lo, min(hi, value))
+
+
+def acos_table():
+    """ACOS_Q4 of src/SampleWindow.cpp, acos(i / ACOS_STEPS) rounded half up."""
+    return [int(math.floor(math.degrees(math.acos(i / ACOS_STEPS)) * ANGLE_SCALE + 0.5))
+            for i in range(ACOS_STEPS + 1)]
+
+
+ACOS_Q4 = acos_table()
+
+
+def angle_q4(raw):
+    """SampleWindow::AngleQ4() of a raw value, integer math only."""
+    raw = max(-COUNTS_PER_G, min(COUNTS_PER_G, raw))
+    g = (abs(raw) << 16) // COUNTS_PER_G
+    index = g >> 8
+    angle = ACOS_Q4[index]
+    if index < ACOS_STEPS:
+        angle -= ((angle - ACOS_Q4[index + 1]) * (g & 0xFF) + 128) >> 8
+    return 180 * ANGLE_SCALE - angle if raw < 0 else angle
+
+
+def degrees_q4(angle):
+    """An angle in degrees as SampleWindow::AngleQ4() units."""
+    return max(0, min(180 * ANGLE_SCALE, int(math.floor(angle * ANGLE_SCALE + 0.5))))
+
+
+def extract_features(window):
+    """window: list of (angleX, angleY, angleZ) in AngleQ4() units, the integer
+    math of extractFeatures() in Classifier.cpp."""
+    n = len(window)
+    if n == 0:
+        return [0] * len(FEATURES)      # neutral, like an empty SampleWindow
+    total = [sum(s[a] for s in window) for a in range(3)]
+    rangeY = max(s[1] for s in window) - min(s[1] for s in window)
+    rangeZ = max(s[2] for s in window) - min(s[2] for s in window)
+    # floor((total / n - 90 * scale) / scale + 1/2), Python // floors like divFloor()
+    mean = [(2 * (t - 90 * ANGLE_SCALE * n) + ANGLE_SCALE * n) // (2 * ANGLE_SCALE * n)
+            for t in total]
+    return [
+        quantize(mean[0], -128, 127),
+        quantize(mean[1], -128, 127),
+        quantize(mean[2], -128, 127),
+        quantize((rangeY + ANGLE_SCALE // 2) // ANGLE_SCALE, 0, 127),
+        quantize((rangeZ + ANGLE_SCALE // 2) // ANGLE_SCALE, 0, 127),
+    ]
+
+
+def load_trace(path):
+    label = None
+    samples = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith("#"):
+                key, _, value = line[1:].partition(":")
+                if key.strip() == "label":
+                    label = value.strip().lower()
+                continue
+            # t_us,x,y,z or x,y,z; column headers and malformed lines are
+            # skipped, like parseTrace() in tools/host/TraceFile.cpp
+            fields = [f for f in re.split(r"[,\s]+", line) if f]
+            if len(fields) not in (3, 4) or not all(NUMBER.match(f) for f in fields):
+                continue
+            x, y, z = (int(v) for v in fields[-3:])
+            samples.append((x, y, z))
+    if label is None:
+        label = os.path.basename(os.path.dirname(os.path.abspath(path))).lower()
+    return label, samples
+
+
+def trace_windows(samples):
+    """Replays MovingAverage and SampleWindow::AngleQ4() over a trace."""
+    ring = [[0] * FILTER_LENGTH for _ in range(3)]
+    index = 0
+    angles = []
+    for i, raw in enumerate(samples):
+        for a in range(3):
+            ring[a][index] = raw[a]
+        index = (index + 1) % FILTER_LENGTH
+        if i < FILTER_LENGTH - 1:
+            continue                # filter not filled yet
+        angle = []
+        for a in range(3):
+            total = sum(ring[a])
+            # rounded half away from zero like MovingAverage::Push()
+            filtered = (abs(total) + FILTER_LENGTH // 2) // FILTER_LENGTH
+            filtered = filtered if total >= 0 else -filtered
+            angle.append(angle_q4(filtered))
+        angles.append(tuple(angle))
+    for start in range(0, len(angles) - WINDOW_LENGTH + 1, WINDOW_LENGTH):
+        yield angles[start:start + WINDOW_LENGTH]
+
+
+def synthetic_windows(count, rng):
+    """Windows drawn from the hand tuned ranges, plus a low motion rest class."""
+    data = []
+    for label in CLASSES:
+        for _ in range(count):
+            if label == "rest":
+                mean = [rng.uniform(0, 180) for _ in range(3)]
+                amplitude = rng.uniform(0, 4)
+            else:
+                mean = [rng.uniform(*r) for r in HAND_TUNED_RANGES[label]]
+                amplitude = rng.uniform(8, 40)
+            freq = rng.uniform(0.3, 1.0)     # repetitions per second
+            phase = rng.uniform(0, 2 * math.pi)
+            window = []
+            for i in range(WINDOW_LENGTH):
+                swing = amplitude * math.sin(2 * math.pi * freq * i * 0.1 + phase)
+                window.append((degrees_q4(mean[0] + rng.gauss(0, 1)),
+                               degrees_q4(mean[1] + swing + rng.gauss(0, 1)),
+                               degrees_q4(mean[2] + 0.5 * swing + rng.gauss(0, 1))))
+            data.append((extract_features(window), CLASSES.index(label)))
+    return data
+
+
+def gini(counts):
+    total = sum(counts)
+    if total == 0:
+        return 0.0
+    return 1.0 - sum((c / total) ** 2 for c in counts)
+
+
+def histogram(rows):
+    counts = [0] * len(CLASSES)
+    for _, label in rows:
+        counts[label] += 1
+    return counts
+
+
+def best_split(rows, min_leaf):
+    best = None
+    parent = gini(histogram(rows)) * len(rows)
+    for f in range(len(FEATURES)):
+        ordered = sorted(rows, key=lambda r: r[0][f])
+        left = [0] * len(CLASSES)
+        right = histogram(ordered)
+        for i in range(len(ordered) - 1):
+            label = ordered[i][1]
+            left[label] += 1
+            right[label] -= 1
+            value = ordered[i][0][f]
+            if value == ordered[i + 1][0][f]:
+                continue
+            if i + 1 < min_leaf or len(ordered) - i - 1 < min_leaf:
+                continue
+            cost = gini(left) * (i + 1) + gini(right) * (len(ordered) - i - 1)
+            if cost < parent - 1e-9 and (best is None or cost < best[0]):
+                best = (cost, f, value)
+    return best
+
+
+def build_tree(rows, depth, max_depth, min_leaf, nodes, leaves):
+    """Appends nodes in pre-order, returns the index of the subtree root."""
+    index = len(nodes)
+    nodes.append(None)
+    split = None
+    if depth < max_depth and len(set(r[1] for r in rows)) > 1:
+        split = best_split(rows, min_leaf)
+    if split is None:
+        nodes[index] = (-1, 0, len(leaves), 0)
+        leaves.append(leaf_confidence(histogram(rows)))
+        return index
+    _, f, threshold = split
+    left = build_tree([r for r in rows if r[0][f] <= threshold],
+                      depth + 1, max_depth, min_leaf, nodes, leaves)
+    right = build_tree([r for r in rows if r[0][f] > threshold],
+                       depth + 1, max_depth, min_leaf, nodes, leaves)
+    nodes[index] = (f, threshold, left, right)
+    return index
+
+
+def leaf_confidence(counts):
+    """Class distribution of a leaf scaled to 0 - 255."""
+    total = sum(counts)
+    return [int(255 * c // total) for c in counts]
+
+
+def evaluate(nodes, leaves, features):
+    i = 0
+    while nodes[i][0] >= 0:
+        f, threshold, left, right = nodes[i]
+        i = left if features[f] <= threshold else right
+    return leaves[nodes[i][2]]
+
+
+def write_header(path, nodes, leaves, max_depth, source):
+    out = []
+    out.append("/*****************************************************************************")
+    out.append("File name: ClassifierModel.h")
+    out.append("Description: Decision tree tables for the on-device exercise classifier.")
+    out.append("Generated by tools/train_classifier.py from %s -- do not edit." % source)
+    out.append("*****************************************************************************/")
+    out.append("")
+    out.append("#ifndef CLASSIFIER_MODEL_H")
+    out.append("#define CLASSIFIER_MODEL_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("#define MODEL_CLASS_COUNT %d" % len(CLASSES))
+    out.append("#define MODEL_FEATURE_COUNT %d" % len(FEATURES))
+    out.append("#define MODEL_NODE_COUNT %d" % len(nodes))
+    out.append("#define MODEL_MAX_DEPTH %d" % max_depth)
+    out.append("")
+    out.append("/* exercise classes, in the order of the confidence table columns */")
+    out.append("enum ModelClass {")
+    for i, label in enumerate(CLASSES):
+        out.append("    MODEL_%s = %d," % (label.upper(), i))
+    out.append("};")
+    out.append("")
+    out.append("/* input features, int8: " + ", ".join(FEATURES) + " */")
+    out.append("enum ModelFeature {")
+    for i, name in enumerate(FEATURES):
+        out.append("    FEATURE_%s = %d," % (name.upper(), i))
+    out.append("};")
+    out.append("")
+    out.append("/* feature < 0 marks a leaf, left is then the row in MODEL_LEAVES */")
+    out.append("struct ModelNode {")
+    out.append("    int8_t feature;")
+    out.append("    int8_t threshold;          // go left when feature value <= threshold")
+    out.append("    uint8_t left;")
+    out.append("    uint8_t right;")
+    out.append("};")
+    out.append("")
+    out.append("static const char *const MODEL_CLASS_NAMES[MODEL_CLASS_COUNT] = {")
+    out.append("    " + ", ".join('"%s"' % n for n in CLASS_NAMES))
+    out.append("};")
+    out.append("")
+    out.append("constexpr ModelNode MODEL_NODES[MODEL_NODE_COUNT] = {")
+    for f, threshold, left, right in nodes:
+        out.append("    {%d, %d, %d, %d}," % (f, threshold, left, right))
+    out.append("};")
+    out.append("")
+    out.append("/* per class confidence of each leaf, 0 - 255 */")
+    out.append("constexpr uint8_t MODEL_LEAVES[%d][MODEL_CLASS_COUNT] = {" % len(leaves))
+    for leaf in leaves:
+        out.append("    {" + ", ".join("%d" % c for c in leaf) + "},")
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    with open(path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("traces", nargs="*", help="trace files or directories")
+    parser.add_argument("-o", "--output", default="include/ClassifierModel.h")
+    parser.add_argument("--synthetic", type=int, default=0, metavar="N",
+                        help="add N synthetic windows per class from the hand tuned ranges")
+    parser.add_argument("--max-depth", type=int, default=6)
+    parser.add_argument("--min-leaf", type=int, default=25)
+    parser.add_argument("--seed", type=int, default=6483)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    rows = []
+    files = []
+    for path in args.traces:
+        if os.path.isdir(path):
+            for root, _, names in os.walk(path):
+                files += [os.path.join(root, n) for n in sorted(names) if n.endswith(".csv")]
+        else:
+            files.append(path)
+    for path in files:
+        label, samples = load_trace(path)
+        if label not in CLASSES:
+            print("skipping %s: unknown label '%s'" % (path, label), file=sys.stderr)
+            continue
+        for window in trace_windows(samples):
+            rows.append((extract_features(window), CLASSES.index(label)))
+    if args.synthetic:
+        rows += synthetic_windows(args.synthetic, rng)
+    if not rows:
+        parser.error("no training data, pass trace files or --synthetic")
+    if args.max_depth > 15:
+        parser.error("--max-depth is limited to 15 so node indices fit in uint8")
+
+    rng.shuffle(rows)
+    holdout = rows[:len(rows) // 5]
+    nodes, leaves = [], []
+    build_tree(rows[len(rows) // 5:], 0, args.max_depth, args.min_leaf, nodes, leaves)
+    if len(nodes) > 255:
+        sys.exit("tree has %d nodes, at most 255 fit in uint8 indices" % len(nodes))
+
+    correct = 0
+    for features, label in holdout:
+        confidence = evaluate(nodes, leaves, features)
+        correct += confidence.index(max(confidence)) == label
+    source = "%d trace files" % len(files) if files else "synthetic data"
+    if files and args.synthetic:
+        source += " and synthetic data"
+    write_header(args.output, nodes, leaves, args.max_depth, source)
+    print("%d windows, %d nodes, %d leaves, holdout accuracy %.1f%%" % (
+        len(rows), len(nodes), len(leaves), 100.0 * correct / max(1, len(holdout))))
+
+
+if __name__ == "__main__":
+    main()